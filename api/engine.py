@@ -7,19 +7,29 @@ The C++ binary runs in interactive mode (no args):
   - writes output lines ending with "OK" or "ERROR ..."
   - emits BOOK/TRADE lines before the terminal OK
 
-This module owns the single long-lived subprocess and serializes all
-commands through an asyncio Lock so concurrent HTTP requests don't
-interleave writes/reads.
+Commands are pipelined: each one is written as "@<tag> <command>" and the
+engine prefixes every reply line with the same tag. A single reader task
+demultiplexes reply lines back to the future of the command that owns the
+tag, so many HTTP requests can have commands in flight at once. The number
+of outstanding commands is bounded by a window (LOB_MAX_INFLIGHT).
+
+Setting `stage_times` to a dict of lists (bench/bridge_bench.py does) makes
+every command append how long it spent in each stage, in seconds:
+lock_wait (in-flight window + write lock), write (pipe write and drain),
+engine (drained → reply handed back: engine, stdout pipe and reader task)
+and parse (reply lines → models).
 """
 from __future__ import annotations
 
 import asyncio
+import collections
 import os
 import re
 import logging
+import time
 from typing import Optional
 
-from .models import TradeEvent, BookSnapshot
+from .models import TradeEvent, BookSnapshot, BookDepth, DepthLevel, EngineStats, OpLatency, SlowLog, SlowOp
 
 logger = logging.getLogger("lob.engine")
 
@@ -29,18 +39,74 @@ _BINARY_PATH = os.environ.get(
     os.path.join(os.path.dirname(__file__), "..", "build", "lob"),
 )
 
+# Per-account pre-trade limits (lob --risk): orders breaching them fail
+# with "risk: <limit>".
+_ENGINE_ARGS = ["--risk", os.environ["LOB_RISK"]] if os.environ.get("LOB_RISK") else []
+
+# Maximum number of commands written to the engine but not yet answered.
+_MAX_INFLIGHT = int(os.environ.get("LOB_MAX_INFLIGHT", "256"))
+
+# Seconds to wait for the reply to a single command.
+_REPLY_TIMEOUT = 3.0
+
 
 class EngineError(RuntimeError):
     pass
 
 
+def record_stages(into: dict[str, list[float]], **durations: float) -> None:
+    for stage, dt in durations.items():
+        into.setdefault(stage, []).append(dt)
+
+
+class InflightWindow:
+    """
+    FIFO limit on outstanding commands. Used instead of asyncio.Semaphore,
+    whose wake-up scans every waiter and goes quadratic once thousands of
+    requests are queued behind a full window.
+    """
+
+    def __init__(self, size: int) -> None:
+        self._free = size
+        self._waiters: collections.deque[asyncio.Future] = collections.deque()
+
+    async def __aenter__(self) -> None:
+        if self._free > 0 and not self._waiters:
+            self._free -= 1
+            return
+        fut = asyncio.get_running_loop().create_future()
+        self._waiters.append(fut)
+        try:
+            await fut   # the slot is handed over directly by _release
+        except asyncio.CancelledError:
+            if fut.done() and not fut.cancelled():
+                self._release()
+            raise
+
+    async def __aexit__(self, *exc) -> None:
+        self._release()
+
+    def _release(self) -> None:
+        while self._waiters:
+            fut = self._waiters.popleft()
+            if not fut.done():
+                fut.set_result(None)
+                return
+        self._free += 1
+
+
 class LOBEngine:
     """Async wrapper around the C++ LOB subprocess."""
 
-    def __init__(self) -> None:
+    def __init__(self, max_inflight: int = _MAX_INFLIGHT) -> None:
         self._proc: Optional[asyncio.subprocess.Process] = None
-        self._lock = asyncio.Lock()
+        self._write_lock = asyncio.Lock()
+        self._window = InflightWindow(max_inflight)
+        self._pending: dict[str, tuple[asyncio.Future, list[str]]] = {}
+        self._next_tag = 0
+        self._reader: Optional[asyncio.Task] = None
         self._ready = False
+        self.stage_times: Optional[dict[str, list[float]]] = None
 
     async def start(self) -> None:
         """Spawn the C++ binary and wait for READY."""
@@ -53,6 +119,7 @@ class LOBEngine:
 
         self._proc = await asyncio.create_subprocess_exec(
             binary,
+            *_ENGINE_ARGS,
             stdin=asyncio.subprocess.PIPE,
             stdout=asyncio.subprocess.PIPE,
             stderr=asyncio.subprocess.PIPE,
@@ -68,12 +135,16 @@ class LOBEngine:
             raise EngineError(f"Unexpected startup line: {line!r}")
 
         self._ready = True
+        self._reader = asyncio.create_task(self._read_replies())
         logger.info("C++ LOB engine started (pid=%d)", self._proc.pid)
 
     async def stop(self) -> None:
         if self._proc and self._proc.returncode is None:
             self._proc.stdin.close()
             await self._proc.wait()
+        if self._reader:
+            await self._reader
+            self._reader = None
         self._ready = False
 
     @property
@@ -82,9 +153,43 @@ class LOBEngine:
 
     # ── low-level command runner ───────────────────────────────────────────────
 
+    async def _read_replies(self) -> None:
+        """
+        Single reader task: routes every "@<tag> <line>" reply to the pending
+        command with that tag and resolves its future on the terminal
+        OK / ERROR line. On EOF every outstanding command fails.
+        """
+        try:
+            while True:
+                raw = await self._proc.stdout.readline()
+                if not raw:
+                    break
+                tag, _, line = raw.decode().rstrip("\n").partition(" ")
+                entry = self._pending.get(tag)
+                if entry is None:
+                    logger.warning("Dropping reply line for unknown tag: %r", raw)
+                    continue
+                fut, output_lines = entry
+                if line == "OK":
+                    del self._pending[tag]
+                    if not fut.done():
+                        fut.set_result(output_lines)
+                elif line.startswith("ERROR"):
+                    del self._pending[tag]
+                    if not fut.done():
+                        fut.set_exception(EngineError(line[len("ERROR "):].strip()))
+                else:
+                    output_lines.append(line)
+        finally:
+            self._ready = False
+            pending, self._pending = self._pending, {}
+            for fut, _ in pending.values():
+                if not fut.done():
+                    fut.set_exception(EngineError("Engine process died unexpectedly"))
+
     async def _send(self, cmd: str) -> list[str]:
         """
-        Send one command line to the engine and collect all reply lines
+        Send one command line to the engine and wait for its reply lines
         up to (and excluding) the terminal OK / ERROR line.
         Returns the list of output lines (without the terminal line).
         Raises EngineError on ERROR response or subprocess death.
@@ -92,25 +197,36 @@ class LOBEngine:
         if not self.is_ready:
             raise EngineError("Engine is not running")
 
-        async with self._lock:
-            self._proc.stdin.write((cmd + "\n").encode())
-            await self._proc.stdin.drain()
-
-            output_lines: list[str] = []
-            while True:
-                raw = await asyncio.wait_for(
-                    self._proc.stdout.readline(), timeout=3.0
-                )
-                if not raw:
-                    raise EngineError("Engine process died unexpectedly")
-                line = raw.decode().rstrip("\n")
-                if line == "OK":
-                    break
-                if line.startswith("ERROR"):
-                    raise EngineError(line[len("ERROR "):].strip())
-                output_lines.append(line)
-
-        return output_lines
+        t0 = time.perf_counter()
+        async with self._window:
+            self._next_tag += 1
+            tag = f"@{self._next_tag}"
+            fut: asyncio.Future = asyncio.get_running_loop().create_future()
+            self._pending[tag] = (fut, [])
+
+            try:
+                async with self._write_lock:
+                    t1 = time.perf_counter()
+                    self._proc.stdin.write(f"{tag} {cmd}\n".encode())
+                    await self._proc.stdin.drain()
+                t2 = time.perf_counter()
+                lines = await asyncio.wait_for(fut, timeout=_REPLY_TIMEOUT)
+                if self.stage_times is not None:
+                    record_stages(self.stage_times, lock_wait=t1 - t0, write=t2 - t1,
+                                  engine=time.perf_counter() - t2)
+                return lines
+            except (BrokenPipeError, ConnectionResetError):
+                raise EngineError("Engine process died unexpectedly")
+            finally:
+                self._pending.pop(tag, None)
+
+    def _timed_parse(self, lines: list[str]) -> tuple[list[TradeEvent], Optional[BookSnapshot]]:
+        if self.stage_times is None:
+            return self._parse_lines(lines)
+        t0 = time.perf_counter()
+        result = self._parse_lines(lines)
+        record_stages(self.stage_times, parse=time.perf_counter() - t0)
+        return result
 
     # ── parsers ───────────────────────────────────────────────────────────────
 
@@ -146,23 +262,77 @@ class LOBEngine:
 
         return trades, book
 
+    @staticmethod
+    def _parse_depth(lines: list[str]) -> BookDepth:
+        level_re = re.compile(r"L2 side=(BUY|SELL) price=(-?\d+) qty=(\d+) orders=(\d+)")
+        bids: list[DepthLevel] = []
+        asks: list[DepthLevel] = []
+        for line in lines:
+            m = level_re.match(line)
+            if m:
+                level = DepthLevel(price=int(m.group(2)), qty=int(m.group(3)), orders=int(m.group(4)))
+                (bids if m.group(1) == "BUY" else asks).append(level)
+        return BookDepth(bids=bids, asks=asks)
+
+    @staticmethod
+    def _parse_stats(lines: list[str]) -> EngineStats:
+        def fields(line: str) -> dict[str, str]:
+            return dict(kv.split("=", 1) for kv in line.split()[1:])
+
+        counters: dict[str, int] = {}
+        latency: list[OpLatency] = []
+        for line in lines:
+            if line.startswith("STATS "):
+                counters = {k: int(v) for k, v in fields(line).items()}
+            elif line.startswith("LATENCY "):
+                f = fields(line)
+                op = f.pop("op")
+                f["p999_ns"] = f.pop("p99.9_ns")
+                latency.append(OpLatency(op=op, **{k: int(v) for k, v in f.items()}))
+        return EngineStats(latency=latency, **counters)
+
+    @staticmethod
+    def _parse_slowlog(lines: list[str]) -> SlowLog:
+        def levels(spec: str) -> list[DepthLevel]:
+            if spec == "-":
+                return []
+            return [DepthLevel(price=int(p), qty=int(q), orders=0)
+                    for p, q in (lvl.split("x") for lvl in spec.split(","))]
+
+        log = SlowLog(total=0, threshold_ns=0)
+        for line in lines:
+            f = dict(kv.split("=", 1) for kv in line.split()[1:])
+            if line.startswith("SLOWLOG "):
+                log.total, log.threshold_ns = int(f["total"]), int(f["threshold_ns"])
+            elif line.startswith("SLOW "):
+                bids, asks = levels(f.pop("bids")), levels(f.pop("asks"))
+                log.entries.append(SlowOp(
+                    cmd=f.pop("cmd"), side=f.pop("side", None), bids=bids, asks=asks,
+                    **{k: int(v) for k, v in f.items()}))
+        return log
+
     # ── public API ────────────────────────────────────────────────────────────
 
+    @staticmethod
+    def _order_options(owner: int, stp: str) -> str:
+        """OWNER / STP words for ADD and MARKET; empty for anonymous orders."""
+        return f" OWNER {owner} STP {stp}" if owner else ""
+
     async def add_limit(
-        self, order_id: int, side: str, price: int, qty: int
+        self, order_id: int, side: str, price: int, qty: int, owner: int = 0, stp: str = "CANCEL_NEWEST"
     ) -> tuple[list[TradeEvent], Optional[BookSnapshot]]:
-        lines = await self._send(f"ADD {order_id} {side} {price} {qty}")
-        return self._parse_lines(lines)
+        lines = await self._send(f"ADD {order_id} {side} {price} {qty}{self._order_options(owner, stp)}")
+        return self._timed_parse(lines)
 
     async def add_market(
-        self, order_id: int, side: str, qty: int
+        self, order_id: int, side: str, qty: int, owner: int = 0, stp: str = "CANCEL_NEWEST"
     ) -> tuple[list[TradeEvent], Optional[BookSnapshot]]:
-        lines = await self._send(f"MARKET {order_id} {side} {qty}")
-        return self._parse_lines(lines)
+        lines = await self._send(f"MARKET {order_id} {side} {qty}{self._order_options(owner, stp)}")
+        return self._timed_parse(lines)
 
     async def cancel(self, order_id: int) -> tuple[bool, Optional[BookSnapshot]]:
         lines = await self._send(f"CANCEL {order_id}")
-        _, book = self._parse_lines(lines)
+        _, book = self._timed_parse(lines)
         found = any("OK" in l for l in lines if l.startswith("CANCEL"))
         # also check for NOT_FOUND
         not_found = any("NOT_FOUND" in l for l in lines)
@@ -172,3 +342,18 @@ class LOBEngine:
         lines = await self._send("STATUS")
         _, book = self._parse_lines(lines)
         return book
+
+    async def depth(self, levels: int) -> BookDepth:
+        """Top `levels` price levels per side with aggregate qty and order count."""
+        lines = await self._send(f"DEPTH {levels}")
+        return self._parse_depth(lines)
+
+    async def stats(self) -> EngineStats:
+        """Book counters and per-operation latency since the engine started."""
+        lines = await self._send("STATS")
+        return self._parse_stats(lines)
+
+    async def slowlog(self, limit: Optional[int] = None) -> SlowLog:
+        """Book calls slower than the engine's --slowlog-us, newest first."""
+        lines = await self._send("SLOWLOG" if limit is None else f"SLOWLOG {limit}")
+        return self._parse_slowlog(lines)
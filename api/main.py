@@ -4,10 +4,12 @@ main.py — FastAPI application for the C++ Limit Order Book engine.
 Endpoints:
   GET  /health                  → engine health check
   GET  /book                    → current best bid/ask
+  GET  /book/depth?levels=N     → top N price levels per side
+  GET  /metrics                 → engine counters and latency (Prometheus text format)
   POST /orders/limit            → place a limit order
   POST /orders/market           → place a market order
   DELETE /orders/{order_id}     → cancel an order
-  WS   /ws                      → real-time trade + book stream
+  WS   /ws                      → real-time trade + book + depth stream
 
 Run locally:
   uvicorn api.main:app --reload --port 8000
@@ -22,16 +24,19 @@ import os
 import random
 import time
 from contextlib import asynccontextmanager
+from typing import Optional
 
 from dotenv import load_dotenv
 load_dotenv()
 
 import httpx
 import yfinance as yf
-from fastapi import FastAPI, WebSocket, WebSocketDisconnect, HTTPException
+from fastapi import FastAPI, WebSocket, WebSocketDisconnect, HTTPException, Query
 from fastapi.middleware.cors import CORSMiddleware
+from fastapi.responses import PlainTextResponse
 
 from .engine import LOBEngine, EngineError
+from .shm_client import ShmEngine
 from .models import (
     LimitOrderRequest,
     MarketOrderRequest,
@@ -39,6 +44,9 @@ from .models import (
     CancelResponse,
     HealthResponse,
     BookSnapshot,
+    BookDepth,
+    EngineStats,
+    SlowLog,
 )
 from .ws_manager import ConnectionManager
 from .commentary import get_commentary
@@ -50,11 +58,15 @@ logging.basicConfig(
 logger = logging.getLogger("lob.api")
 
 # ── Shared singletons ──────────────────────────────────────────────────────────
-engine = LOBEngine()
+# LOB_TRANSPORT=shm swaps the stdin/stdout pipe bridge for the /dev/shm rings.
+engine = ShmEngine() if os.environ.get("LOB_TRANSPORT") == "shm" else LOBEngine()
 ws_manager = ConnectionManager()
 
 TICKERS = ["AAPL", "MSFT", "NVDA", "TSLA", "GOOGL"]
 FEED_SPEED = 0.15   # seconds between bars
+MARKET_FEED = os.environ.get("LOB_MARKET_FEED", "1") != "0"   # replay yfinance bars into the book
+DEPTH_LEVELS = 10       # levels per side in WebSocket depth events
+_last_depth: Optional[dict] = None
 _feed_order_id = 100_000
 
 # ── Commentary state ───────────────────────────────────────────────────────────
@@ -101,6 +113,21 @@ async def _maybe_broadcast_commentary(book, event_type: str):
         logger.warning(f"[commentary] broadcast failed: {e}")
 
 
+async def _broadcast_depth():
+    """Broadcast the depth ladder after a command changed the book."""
+    global _last_depth
+    if ws_manager.client_count == 0:
+        return
+    try:
+        depth = (await engine.depth(DEPTH_LEVELS)).model_dump()
+    except EngineError as e:
+        logger.debug(f"[depth] {e}")
+        return
+    if depth != _last_depth:
+        _last_depth = depth
+        await ws_manager.broadcast("depth", depth)
+
+
 async def _place_limit(side: str, price_cents: int, qty: int) -> dict:
     global _feed_order_id
     _feed_order_id += 1
@@ -113,6 +140,7 @@ async def _place_limit(side: str, price_cents: int, qty: int) -> dict:
         _commentary_state["trade_count"] += 1
     if book:
         await ws_manager.broadcast("book", _book_dict(book))
+        await _broadcast_depth()
         await _maybe_broadcast_commentary(book, "limit")
     return {"trades": trades, "book": book}
 
@@ -129,6 +157,7 @@ async def _place_market(side: str, qty: int) -> dict:
         _commentary_state["trade_count"] += 1
     if book:
         await ws_manager.broadcast("book", _book_dict(book))
+        await _broadcast_depth()
         await _maybe_broadcast_commentary(book, "market_order")
     return {"trades": trades, "book": book}
 
@@ -138,6 +167,8 @@ async def _cancel_feed(order_id: int):
         found, book = await engine.cancel(order_id)
         if book:
             await ws_manager.broadcast("cancel", {"order_id": order_id, "book": _book_dict(book)})
+        if found:
+            await _broadcast_depth()
     except Exception:
         pass
 
@@ -232,9 +263,10 @@ async def market_feed_loop():
 async def lifespan(app: FastAPI):
     """Start the C++ engine and market feed on startup."""
     await engine.start()
-    feed_task = asyncio.create_task(market_feed_loop())
+    feed_task = asyncio.create_task(market_feed_loop()) if MARKET_FEED else None
     yield
-    feed_task.cancel()
+    if feed_task:
+        feed_task.cancel()
     await engine.stop()
 
 
@@ -266,6 +298,39 @@ def _book_dict(book: BookSnapshot | None) -> dict:
     return book.model_dump()
 
 
+# (metric, type, help, EngineStats field)
+_METRICS = [
+    ("lob_orders_added_total", "counter", "Orders accepted (limit and market).", "added"),
+    ("lob_orders_cancelled_total", "counter", "Orders cancelled.", "cancelled"),
+    ("lob_orders_filled_total", "counter", "Resting orders completely filled.", "filled"),
+    ("lob_trades_total", "counter", "Trades executed.", "trades"),
+    ("lob_orders_rejected_total", "counter", "Orders refused by the book.", "rejected"),
+    ("lob_command_errors_total", "counter", "Engine commands answered with ERROR.", "errors"),
+    ("lob_levels", "gauge", "Price levels in the book, both sides.", "levels"),
+    ("lob_resting_orders", "gauge", "Resting orders in the book.", "resting"),
+    ("lob_peak_levels", "gauge", "Most price levels seen at once.", "peak_levels"),
+    ("lob_self_trades_prevented_total", "counter", "Trades between orders of one owner prevented.", "prevented"),
+]
+
+
+def _prometheus(stats: EngineStats) -> str:
+    out: list[str] = []
+    for name, kind, help_text, field in _METRICS:
+        out += [f"# HELP {name} {help_text}", f"# TYPE {name} {kind}", f"{name} {getattr(stats, field)}"]
+
+    name = "lob_op_latency_seconds"
+    out += [f"# HELP {name} Time spent in the book per operation.", f"# TYPE {name} summary"]
+    for lat in stats.latency:
+        for q, ns in (("0.5", lat.p50_ns), ("0.9", lat.p90_ns), ("0.99", lat.p99_ns), ("0.999", lat.p999_ns)):
+            out.append(f'{name}{{op="{lat.op}",quantile="{q}"}} {ns / 1e9:.9f}')
+        out.append(f'{name}_sum{{op="{lat.op}"}} {lat.sum_ns / 1e9:.9f}')
+        out.append(f'{name}_count{{op="{lat.op}"}} {lat.count}')
+
+    out += ["# HELP lob_ws_clients Connected WebSocket clients.", "# TYPE lob_ws_clients gauge",
+            f"lob_ws_clients {ws_manager.client_count}"]
+    return "\n".join(out) + "\n"
+
+
 # ── REST endpoints ────────────────────────────────────────────────────────────
 
 @app.get("/health", response_model=HealthResponse, tags=["Meta"])
@@ -285,10 +350,35 @@ async def get_book():
         raise HTTPException(status_code=503, detail=str(e))
 
 
+@app.get("/book/depth", response_model=BookDepth, tags=["Book"])
+async def get_book_depth(levels: int = Query(10, ge=1, le=1000)):
+    try:
+        return await engine.depth(levels)
+    except EngineError as e:
+        raise HTTPException(status_code=503, detail=str(e))
+
+
+@app.get("/metrics", response_class=PlainTextResponse, tags=["Meta"])
+async def metrics():
+    try:
+        stats = await engine.stats()
+    except EngineError as e:
+        raise HTTPException(status_code=503, detail=str(e))
+    return PlainTextResponse(_prometheus(stats), media_type="text/plain; version=0.0.4")
+
+
+@app.get("/slowlog", response_model=SlowLog, tags=["Meta"])
+async def slowlog(limit: Optional[int] = Query(None, ge=1, le=10_000)):
+    try:
+        return await engine.slowlog(limit)
+    except EngineError as e:
+        raise HTTPException(status_code=503, detail=str(e))
+
+
 @app.post("/orders/limit", response_model=OrderResponse, tags=["Orders"])
 async def place_limit(req: LimitOrderRequest):
     try:
-        trades, book = await engine.add_limit(req.order_id, req.side, req.price, req.qty)
+        trades, book = await engine.add_limit(req.order_id, req.side, req.price, req.qty, req.owner, req.stp)
     except EngineError as e:
         raise HTTPException(status_code=400, detail=str(e))
 
@@ -296,6 +386,7 @@ async def place_limit(req: LimitOrderRequest):
         await ws_manager.broadcast("trade", t.model_dump())
     if book:
         await ws_manager.broadcast("book", _book_dict(book))
+        await _broadcast_depth()
 
     return OrderResponse(status="ok", trades=trades, book=book)
 
@@ -303,7 +394,7 @@ async def place_limit(req: LimitOrderRequest):
 @app.post("/orders/market", response_model=OrderResponse, tags=["Orders"])
 async def place_market(req: MarketOrderRequest):
     try:
-        trades, book = await engine.add_market(req.order_id, req.side, req.qty)
+        trades, book = await engine.add_market(req.order_id, req.side, req.qty, req.owner, req.stp)
     except EngineError as e:
         raise HTTPException(status_code=400, detail=str(e))
 
@@ -311,6 +402,7 @@ async def place_market(req: MarketOrderRequest):
         await ws_manager.broadcast("trade", t.model_dump())
     if book:
         await ws_manager.broadcast("book", _book_dict(book))
+        await _broadcast_depth()
 
     return OrderResponse(status="ok", trades=trades, book=book)
 
@@ -324,6 +416,8 @@ async def cancel_order(order_id: int):
 
     if book:
         await ws_manager.broadcast("cancel", {"order_id": order_id, "book": _book_dict(book)})
+    if found:
+        await _broadcast_depth()
 
     return CancelResponse(
         status="ok" if found else "not_found",
@@ -340,7 +434,8 @@ async def websocket_endpoint(ws: WebSocket):
     try:
         book = await engine.status()
         if book:
-            await ws.send_json({"event": "book", "payload": _book_dict(book)})
+            await ws_manager.send(ws, "book", _book_dict(book))
+        await ws_manager.send(ws, "depth", (await engine.depth(DEPTH_LEVELS)).model_dump())
     except Exception:
         pass
 
@@ -6,17 +6,24 @@ from pydantic import BaseModel, Field
 
 # ── Requests ──────────────────────────────────────────────────────────────────
 
+StpMode = Literal["CANCEL_NEWEST", "CANCEL_OLDEST", "CANCEL_BOTH", "DECREMENT"]
+
+
 class LimitOrderRequest(BaseModel):
     order_id: int = Field(..., gt=0, description="Unique order ID (positive integer)")
     side: Literal["BUY", "SELL"]
     price: int = Field(..., gt=0, description="Limit price (positive integer, e.g. cents)")
     qty: int = Field(..., gt=0, description="Order quantity")
+    owner: int = Field(0, ge=0, lt=2**32, description="Account id; 0 = anonymous (no self-trade prevention)")
+    stp: StpMode = Field("CANCEL_NEWEST", description="What happens instead of a trade with the same owner")
 
 
 class MarketOrderRequest(BaseModel):
     order_id: int = Field(..., gt=0)
     side: Literal["BUY", "SELL"]
     qty: int = Field(..., gt=0)
+    owner: int = Field(0, ge=0, lt=2**32)
+    stp: StpMode = "CANCEL_NEWEST"
 
 
 # ── Responses ─────────────────────────────────────────────────────────────────
@@ -34,6 +41,63 @@ class BookSnapshot(BaseModel):
     spread: Optional[int] = None   # best_ask - best_bid, None if either side is empty
 
 
+class DepthLevel(BaseModel):
+    price: int
+    qty: int      # total resting quantity at this price
+    orders: int   # number of resting orders at this price
+
+
+class BookDepth(BaseModel):
+    bids: list[DepthLevel] = []   # best (highest) price first
+    asks: list[DepthLevel] = []   # best (lowest) price first
+
+
+class OpLatency(BaseModel):
+    op: Literal["add", "market", "cancel"]
+    count: int
+    sum_ns: int
+    p50_ns: int
+    p90_ns: int
+    p99_ns: int
+    p999_ns: int
+    max_ns: int
+
+
+class EngineStats(BaseModel):
+    added: int          # orders accepted (limit and market)
+    cancelled: int
+    filled: int         # resting orders completely filled
+    trades: int
+    rejected: int       # orders the book refused
+    levels: int         # price levels now, both sides
+    resting: int        # resting orders now
+    peak_levels: int
+    prevented: int      # self-trades prevented
+    errors: int         # ERROR replies of any kind
+    latency: list[OpLatency] = []
+
+
+class SlowOp(BaseModel):
+    seq: int                 # slow ops recorded before this one
+    unix_us: int
+    dur_ns: int              # time in the book call
+    cmd: Literal["ADD", "MARKET", "CANCEL"]
+    id: int
+    side: Optional[Literal["BUY", "SELL"]] = None
+    price: Optional[int] = None
+    qty: Optional[int] = None
+    levels: int              # price levels filled against
+    fills: int
+    bids: list[DepthLevel] = []   # top of book right after the call; orders = 0 (not recorded)
+    asks: list[DepthLevel] = []
+
+
+class SlowLog(BaseModel):
+    total: int               # slow ops recorded since startup
+    threshold_ns: int
+    entries: list[SlowOp] = []   # newest first
+
+
 class OrderResponse(BaseModel):
     status: Literal["ok", "error"]
     message: str = ""
@@ -55,5 +119,5 @@ class HealthResponse(BaseModel):
 # ── WebSocket broadcast payload ───────────────────────────────────────────────
 
 class WsMessage(BaseModel):
-    event: Literal["trade", "book", "cancel", "error"]
+    event: Literal["trade", "book", "depth", "cancel", "commentary", "error"]
     payload: dict
@@ -0,0 +1,287 @@
+"""
+shm_client.py — shared-memory transport to the C++ LOB binary.
+
+Drop-in alternative to LOBEngine (same public API). Instead of text over
+stdin/stdout pipes, commands and replies are fixed-size binary records in
+two single-producer / single-consumer rings inside one file under /dev/shm.
+This process creates the file and spawns `lob --shm <name>`, which maps it.
+
+The layout is documented in include/shm_ring.hpp; the struct formats below
+must match ShmCommand / ShmEvent there. Python has no atomics, so ordering
+relies on x86-64 store/load ordering: a record is always written before the
+tail that publishes it, and a tail is always read before the records it
+covers. Counters are accessed through memoryview casts, which compile to a
+single aligned load/store; struct.pack_into zero-fills its target first and
+would briefly expose a torn counter to the engine.
+
+Select it with LOB_TRANSPORT=shm.
+"""
+from __future__ import annotations
+
+import asyncio
+import logging
+import mmap
+import os
+import struct
+import time
+from typing import Optional
+
+from .engine import EngineError, InflightWindow, record_stages, _BINARY_PATH, _ENGINE_ARGS, _REPLY_TIMEOUT
+from .models import TradeEvent, BookSnapshot, BookDepth, DepthLevel, EngineStats, SlowLog
+
+logger = logging.getLogger("lob.shm")
+
+_MAGIC = 0x31304D4853424F4C   # "LOBSHM01"
+_VERSION = 1
+_HEADER_SIZE = 512
+
+_OFF_ENGINE_STATE = 28
+_OFF_CLIENT_STATE = 32
+_OFF_CMD_HEAD = 64
+_OFF_CMD_TAIL = 128
+_OFF_EVT_HEAD = 192
+_OFF_EVT_TAIL = 256
+
+# ShmCommand: tag, id, price, qty, type, side, stp, pad, owner
+_CMD = struct.Struct("<QQqqBBBxI")
+# ShmEvent: tag, type, flags, pad[6], a, b, c, d
+_EVT = struct.Struct("<QBB6xqqQQ")
+
+_CMD_ADD, _CMD_MARKET, _CMD_CANCEL, _CMD_STATUS, _CMD_DEPTH = 1, 2, 3, 4, 5
+_EVT_TRADE, _EVT_BOOK, _EVT_CANCEL, _EVT_OK, _EVT_ERROR, _EVT_LEVEL = 1, 2, 3, 4, 5, 6
+_SIDES = {"BUY": 0, "SELL": 1}
+_STP_MODES = {"CANCEL_NEWEST": 0, "CANCEL_OLDEST": 1, "CANCEL_BOTH": 2, "DECREMENT": 3}
+
+_CMD_CAPACITY = 4096
+_EVT_CAPACITY = 16384
+
+
+class ShmEngine:
+    """Async client for `lob --shm`, API-compatible with LOBEngine."""
+
+    def __init__(self, name: Optional[str] = None) -> None:
+        self._name = name or f"lob-{os.getpid()}"
+        self._path = f"/dev/shm/{self._name}"
+        self._mm: Optional[mmap.mmap] = None
+        self._u32: Optional[memoryview] = None   # header viewed as uint32[]
+        self._u64: Optional[memoryview] = None   # header viewed as uint64[]
+        self._proc: Optional[asyncio.subprocess.Process] = None
+        self._pending: dict[int, tuple[asyncio.Future, list[tuple]]] = {}
+        self._next_tag = 0
+        # At most _CMD_CAPACITY commands in flight, so the command ring never fills.
+        self._window = InflightWindow(_CMD_CAPACITY)
+        self._poller: Optional[asyncio.Task] = None
+        self._evt_off = 0
+        self._ready = False
+        # Per-stage timings, as LOBEngine.stage_times (write = ring push).
+        self.stage_times: Optional[dict[str, list[float]]] = None
+
+    # ── lifecycle ─────────────────────────────────────────────────────────────
+
+    async def start(self) -> None:
+        """Create the channel, spawn `lob --shm` and wait for it to attach."""
+        binary = os.path.abspath(_BINARY_PATH)
+        if not os.path.isfile(binary):
+            raise FileNotFoundError(
+                f"LOB binary not found at {binary}. "
+                "Run: cmake --build build --target lob"
+            )
+
+        self._evt_off = (_HEADER_SIZE + _CMD_CAPACITY * _CMD.size + 63) & ~63
+        size = self._evt_off + _EVT_CAPACITY * _EVT.size
+        with open(self._path, "w+b") as f:
+            f.truncate(size)
+            self._mm = mmap.mmap(f.fileno(), size)
+
+        self._u32 = memoryview(self._mm)[:_HEADER_SIZE].cast("I")
+        self._u64 = memoryview(self._mm)[:_HEADER_SIZE].cast("Q")
+        struct.pack_into("<IIIIII", self._mm, 8,
+                         _VERSION, _CMD_CAPACITY, _EVT_CAPACITY, _CMD.size, _EVT.size, 0)
+        self._u32[_OFF_CLIENT_STATE // 4] = 1
+        self._u64[0] = _MAGIC   # magic last
+
+        self._proc = await asyncio.create_subprocess_exec(binary, "--shm", self._name, *_ENGINE_ARGS)
+
+        loop = asyncio.get_running_loop()
+        deadline = loop.time() + 5.0
+        while self._u32[_OFF_ENGINE_STATE // 4] != 1:
+            if self._proc.returncode is not None or loop.time() > deadline:
+                raise EngineError("C++ engine did not attach to shared memory within 5 s")
+            await asyncio.sleep(0.01)
+
+        self._ready = True
+        self._poller = asyncio.create_task(self._poll_events())
+        logger.info("C++ LOB engine attached via %s (pid=%d)", self._path, self._proc.pid)
+
+    async def stop(self) -> None:
+        if self._mm is not None:
+            self._u32[_OFF_CLIENT_STATE // 4] = 2
+        if self._proc and self._proc.returncode is None:
+            await self._proc.wait()
+        self._ready = False
+        if self._poller:
+            self._poller.cancel()
+            self._poller = None
+        if self._mm is not None:
+            self._u32.release()
+            self._u64.release()
+            self._mm.close()
+            self._mm = None
+            os.unlink(self._path)
+
+    @property
+    def is_ready(self) -> bool:
+        return self._ready and self._proc is not None and self._proc.returncode is None
+
+    # ── rings ─────────────────────────────────────────────────────────────────
+
+    def _push_command(self, tag: int, kind: int, order_id: int = 0, side: str = "BUY",
+                      price: int = 0, qty: int = 0, owner: int = 0, stp: str = "CANCEL_NEWEST") -> bool:
+        ctr = self._u64
+        tail = ctr[_OFF_CMD_TAIL // 8]
+        head = ctr[_OFF_CMD_HEAD // 8]
+        if tail - head >= _CMD_CAPACITY:
+            return False
+        off = _HEADER_SIZE + (tail & (_CMD_CAPACITY - 1)) * _CMD.size
+        _CMD.pack_into(self._mm, off, tag, order_id, price, qty, kind, _SIDES[side], _STP_MODES[stp], owner)
+        ctr[_OFF_CMD_TAIL // 8] = tail + 1
+        return True
+
+    async def _poll_events(self) -> None:
+        """Single consumer of the event ring; resolves futures on Ok / Error."""
+        mm, ctr = self._mm, self._u64
+        idle = 0
+        while True:
+            head = ctr[_OFF_EVT_HEAD // 8]
+            tail = ctr[_OFF_EVT_TAIL // 8]
+            if head == tail:
+                if self._proc.returncode is not None:
+                    break
+                idle += 1
+                # Yield to other tasks while busy, sleep once idle for a while.
+                await asyncio.sleep(0 if idle < 100 else 0.0005)
+                continue
+            idle = 0
+            while head != tail:
+                off = self._evt_off + (head & (_EVT_CAPACITY - 1)) * _EVT.size
+                ev = _EVT.unpack_from(mm, off)
+                head += 1
+                self._dispatch(ev)
+            ctr[_OFF_EVT_HEAD // 8] = head
+            await asyncio.sleep(0)
+
+        self._ready = False
+        pending, self._pending = self._pending, {}
+        for fut, _ in pending.values():
+            if not fut.done():
+                fut.set_exception(EngineError("Engine process died unexpectedly"))
+
+    def _dispatch(self, ev: tuple) -> None:
+        tag, kind = ev[0], ev[1]
+        entry = self._pending.get(tag)
+        if entry is None:
+            logger.warning("Dropping event for unknown tag %d", tag)
+            return
+        fut, events = entry
+        if kind == _EVT_OK:
+            del self._pending[tag]
+            if not fut.done():
+                fut.set_result(events)
+        elif kind == _EVT_ERROR:
+            del self._pending[tag]
+            msg = struct.pack("<qqQQ", *ev[3:]).rstrip(b"\0").decode(errors="replace")
+            if not fut.done():
+                fut.set_exception(EngineError(msg))
+        else:
+            events.append(ev)
+
+    async def _send(self, kind: int, **fields) -> list[tuple]:
+        if not self.is_ready:
+            raise EngineError("Engine is not running")
+        t0 = time.perf_counter()
+        async with self._window:
+            self._next_tag += 1
+            tag = self._next_tag
+            fut: asyncio.Future = asyncio.get_running_loop().create_future()
+            self._pending[tag] = (fut, [])
+            try:
+                t1 = time.perf_counter()
+                if not self._push_command(tag, kind, **fields):
+                    raise EngineError("Command ring full")
+                t2 = time.perf_counter()
+                events = await asyncio.wait_for(fut, timeout=_REPLY_TIMEOUT)
+                if self.stage_times is not None:
+                    record_stages(self.stage_times, lock_wait=t1 - t0, write=t2 - t1,
+                                  engine=time.perf_counter() - t2)
+                return events
+            finally:
+                self._pending.pop(tag, None)
+
+    def _timed_parse(self, events: list[tuple]) -> tuple[list[TradeEvent], Optional[BookSnapshot], bool]:
+        if self.stage_times is None:
+            return self._parse_events(events)
+        t0 = time.perf_counter()
+        result = self._parse_events(events)
+        record_stages(self.stage_times, parse=time.perf_counter() - t0)
+        return result
+
+    # ── parsers ───────────────────────────────────────────────────────────────
+
+    @staticmethod
+    def _parse_events(events: list[tuple]) -> tuple[list[TradeEvent], Optional[BookSnapshot], bool]:
+        trades: list[TradeEvent] = []
+        book: Optional[BookSnapshot] = None
+        found = False
+        for _, kind, flags, a, b, c, d in events:
+            if kind == _EVT_TRADE:
+                trades.append(TradeEvent(price=a, qty=b, buy_id=c, sell_id=d))
+            elif kind == _EVT_BOOK:
+                bid = a if flags & 1 else None
+                ask = b if flags & 2 else None
+                spread = (ask - bid) if (bid is not None and ask is not None) else None
+                book = BookSnapshot(best_bid=bid, best_ask=ask, spread=spread)
+            elif kind == _EVT_CANCEL:
+                found = bool(flags & 1)
+        return trades, book, found
+
+    # ── public API ────────────────────────────────────────────────────────────
+
+    async def add_limit(
+        self, order_id: int, side: str, price: int, qty: int, owner: int = 0, stp: str = "CANCEL_NEWEST"
+    ) -> tuple[list[TradeEvent], Optional[BookSnapshot]]:
+        events = await self._send(_CMD_ADD, order_id=order_id, side=side, price=price, qty=qty, owner=owner, stp=stp)
+        trades, book, _ = self._timed_parse(events)
+        return trades, book
+
+    async def add_market(
+        self, order_id: int, side: str, qty: int, owner: int = 0, stp: str = "CANCEL_NEWEST"
+    ) -> tuple[list[TradeEvent], Optional[BookSnapshot]]:
+        events = await self._send(_CMD_MARKET, order_id=order_id, side=side, qty=qty, owner=owner, stp=stp)
+        trades, book, _ = self._timed_parse(events)
+        return trades, book
+
+    async def cancel(self, order_id: int) -> tuple[bool, Optional[BookSnapshot]]:
+        events = await self._send(_CMD_CANCEL, order_id=order_id)
+        _, book, found = self._timed_parse(events)
+        return found, book
+
+    async def status(self) -> Optional[BookSnapshot]:
+        events = await self._send(_CMD_STATUS)
+        _, book, _ = self._parse_events(events)
+        return book
+
+    async def depth(self, levels: int) -> BookDepth:
+        events = await self._send(_CMD_DEPTH, qty=levels)
+        bids: list[DepthLevel] = []
+        asks: list[DepthLevel] = []
+        for _, kind, flags, a, b, c, _ in events:
+            if kind == _EVT_LEVEL:
+                (asks if flags & 1 else bids).append(DepthLevel(price=a, qty=b, orders=c))
+        return BookDepth(bids=bids, asks=asks)
+
+    async def stats(self) -> EngineStats:
+        # The shm protocol has no STATS records (include/shm_ring.hpp).
+        raise EngineError("STATS is only available over the pipe transport")
+
+    async def slowlog(self, limit: Optional[int] = None) -> SlowLog:
+        raise EngineError("SLOWLOG is only available over the pipe transport")
@@ -3,47 +3,162 @@ ws_manager.py — WebSocket connection manager.
 
 All connected clients receive every trade and book-update event
 broadcast by the REST handlers in real time.
+
+broadcast() never waits on a socket: it appends the message to a bounded
+per-client queue that a writer task per client drains. Book state is
+conflated — a book message still queued for a client is replaced by the
+newer one for the same symbol, so a slow client skips intermediate books.
+Only books queued after the client's last pending trade, cancel or
+commentary are replaced: a book never overtakes an event queued before it,
+so a client never sees a book reflecting fills it hasn't been told about.
+Trades, cancels and commentary are never dropped; a client whose backlog
+of those exceeds the queue bound is disconnected instead (it resyncs from
+the snapshot sent on reconnect).
+
+Each event is serialized once and the same string is queued to every
+client. A writer that finds several messages queued sends them as one
+frame holding a JSON array, so a client that has fallen behind catches up
+in a few large frames instead of one round through the event loop per
+event. Frames are therefore either one {"event", "payload"} object or an
+array of them.
 """
 from __future__ import annotations
 
 import asyncio
+import collections
 import json
 import logging
-from typing import Any
+import os
+from typing import Any, Optional
 
 from fastapi import WebSocket
 
 logger = logging.getLogger("lob.ws")
 
+# Maximum number of messages queued for one client.
+_MAX_QUEUE = int(os.environ.get("LOB_WS_MAX_QUEUE", "1024"))
+
+# Maximum number of messages coalesced into one frame.
+_MAX_BATCH = int(os.environ.get("LOB_WS_MAX_BATCH", "256"))
+
+# Events that carry book state: only the newest per symbol is worth sending.
+_CONFLATED_EVENTS = frozenset({"book", "depth"})
+
+
+class _Client:
+    """One connection: a FIFO of pending messages plus its writer task."""
+
+    def __init__(self, ws: WebSocket) -> None:
+        self.ws = ws
+        # Each entry is [conflation key or None, message]; conflated entries
+        # are rewritten in place while nothing else has been queued after
+        # them (`latest` only holds those).
+        self.queue: collections.deque[list] = collections.deque()
+        self.latest: dict[tuple, list] = {}
+        self.wakeup = asyncio.Event()
+        self.task: Optional[asyncio.Task] = None
+        self.conflated = 0
+
+    def push(self, key: Optional[tuple], msg: str) -> bool:
+        """Queues `msg`; returns False if the client is hopelessly behind."""
+        if key is not None:
+            entry = self.latest.get(key)
+            if entry is not None:
+                entry[1] = msg
+                self.conflated += 1
+                return True
+        if len(self.queue) >= _MAX_QUEUE:
+            return False
+        entry = [key, msg]
+        self.queue.append(entry)
+        if key is not None:
+            self.latest[key] = entry
+        else:
+            # Books queued before this event stay where they are; the next
+            # book for their symbol is queued after it.
+            self.latest.clear()
+        self.wakeup.set()
+        return True
+
+    def pop_frame(self) -> str:
+        """Takes up to _MAX_BATCH queued messages as one frame."""
+        n = min(len(self.queue), _MAX_BATCH)
+        msgs = []
+        for _ in range(n):
+            entry = self.queue.popleft()
+            key, msg = entry
+            if key is not None and self.latest.get(key) is entry:
+                del self.latest[key]
+            msgs.append(msg)
+        return msgs[0] if n == 1 else "[" + ",".join(msgs) + "]"
+
 
 class ConnectionManager:
     def __init__(self) -> None:
-        self._clients: list[WebSocket] = []
-        self._lock = asyncio.Lock()
+        self._clients: dict[WebSocket, _Client] = {}
+
+    @property
+    def client_count(self) -> int:
+        return len(self._clients)
 
     async def connect(self, ws: WebSocket) -> None:
         await ws.accept()
-        async with self._lock:
-            self._clients.append(ws)
+        client = _Client(ws)
+        client.task = asyncio.create_task(self._writer(client))
+        self._clients[ws] = client
         logger.info("WS client connected  (total=%d)", len(self._clients))
 
     async def disconnect(self, ws: WebSocket) -> None:
-        async with self._lock:
-            self._clients = [c for c in self._clients if c is not ws]
+        self._drop(ws)
         logger.info("WS client disconnected (total=%d)", len(self._clients))
 
     async def broadcast(self, event: str, payload: dict[str, Any]) -> None:
-        """Send a JSON message to all connected clients."""
-        msg = json.dumps({"event": event, "payload": payload})
-        dead: list[WebSocket] = []
-        async with self._lock:
-            clients = list(self._clients)
-        for ws in clients:
-            try:
-                await ws.send_text(msg)
-            except Exception:
-                dead.append(ws)
-        # Clean up closed sockets
-        if dead:
-            async with self._lock:
-                self._clients = [c for c in self._clients if c not in dead]
+        """Queue a JSON message for all connected clients."""
+        await self._publish(list(self._clients.items()), event, payload)
+
+    async def send(self, ws: WebSocket, event: str, payload: dict[str, Any]) -> None:
+        """Queue a JSON message for one client, in order with broadcasts."""
+        client = self._clients.get(ws)
+        if client is not None:
+            await self._publish([(ws, client)], event, payload)
+
+    async def _publish(self, targets: list, event: str, payload: dict[str, Any]) -> None:
+        msg = json.dumps({"event": event, "payload": payload}, separators=(",", ":"))
+        key = (event, payload.get("symbol")) if event in _CONFLATED_EVENTS else None
+        for ws, client in targets:
+            if not client.push(key, msg):
+                logger.warning("WS client too slow (%d queued), disconnecting", len(client.queue))
+                self._drop(ws)
+                await self._close(ws)
+
+    # ── per-client writer ─────────────────────────────────────────────────────
+
+    async def _writer(self, client: _Client) -> None:
+        try:
+            while True:
+                while client.queue:
+                    await client.ws.send_text(client.pop_frame())
+                client.wakeup.clear()
+                await client.wakeup.wait()
+        except asyncio.CancelledError:
+            raise
+        except Exception:
+            # Closed socket: stop writing; the endpoint's receive loop or the
+            # next broadcast notices and drops the client.
+            self._drop(client.ws)
+
+    def _drop(self, ws: WebSocket) -> None:
+        client = self._clients.pop(ws, None)
+        if client is None:
+            return
+        if client.task is not None and client.task is not asyncio.current_task():
+            client.task.cancel()
+        if client.conflated:
+            logger.info("WS client conflated %d book update(s)", client.conflated)
+
+    @staticmethod
+    async def _close(ws: WebSocket) -> None:
+        try:
+            await ws.close(code=1013)   # try again later
+        except Exception:
+            pass
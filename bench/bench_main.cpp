@@ -0,0 +1,43 @@
+// Entry point of lob_benchmarks: Google Benchmark's own flags, plus --perf,
+// which adds hardware counters per iteration to every benchmark
+// (bench_perf.hpp).
+//
+//   ./lob_benchmarks --perf --benchmark_filter=Cancel
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "bench_perf.hpp"
+
+namespace {
+std::unique_ptr<PerfCounters> g_perf;
+}  // namespace
+
+PerfCounters* bench_perf() { return g_perf.get(); }
+
+int main(int argc, char** argv) {
+    bool perf = false;
+    int  kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--perf") == 0) perf = true;
+        else argv[kept++] = argv[i];
+    }
+    argc       = kept;
+    argv[argc] = nullptr;
+
+    if (perf) {
+        g_perf = std::make_unique<PerfCounters>();
+        if (!g_perf->available()) {
+            std::cerr << "--perf: hardware counters unavailable (" << g_perf->error() << "), timing only\n";
+            g_perf.reset();
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
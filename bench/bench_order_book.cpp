@@ -0,0 +1,195 @@
+// Per-operation microbenchmarks for OrderBook (Google Benchmark).
+//
+// Every benchmark times a single operation against a book of known shape and
+// restores the shape outside the timed region, so numbers stay comparable
+// across iterations and across data-structure changes. The argument is the
+// book size the operation runs against (levels, queue depth or sweep width).
+//
+// Where the shape has to be restored after every operation, the operation is
+// timed by hand (UseManualTime): PauseTiming/ResumeTiming cost several
+// hundred ns each and would swamp sub-microsecond operations.
+//
+// With --perf, hardware counters cover the same region as the timer: the
+// whole loop body, or for manually timed benchmarks just the timed operation
+// (plus the two clock reads around it).
+//
+//   ./lob_benchmarks --benchmark_filter=Cancel
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "bench_perf.hpp"
+#include "order_book.hpp"
+
+namespace {
+
+constexpr std::int64_t kMid      = 100'000;
+constexpr std::int64_t kQty      = 10;
+constexpr OrderId      kFirstAsk = 1'000'000'000;  // ask ids never collide with bid ids
+
+// Bids at kMid-1, kMid-2, ... and asks at kMid+1, kMid+2, ..., `per_level`
+// orders of kQty each. Bid ids count up from 1, ask ids from kFirstAsk.
+struct Book {
+    OrderBook ob;
+    OrderId   next_bid = 1;
+    OrderId   next_ask = kFirstAsk;
+
+    Book(int levels, int per_level) {
+        for (int l = 0; l < levels; ++l) {
+            for (int i = 0; i < per_level; ++i) {
+                (void)ob.add_limit(next_bid++, Side::Buy,  kMid - 1 - l, kQty);
+                (void)ob.add_limit(next_ask++, Side::Sell, kMid + 1 + l, kQty);
+            }
+        }
+    }
+
+    // Re-adds one order at each of the best `levels` ask prices.
+    void refill_asks(int levels) {
+        for (int l = 0; l < levels; ++l) (void)ob.add_limit(next_ask++, Side::Sell, kMid + 1 + l, kQty);
+    }
+};
+
+// Runs `op` as the timed (and counted) part of one manually timed iteration.
+template <typename Op>
+void timed(benchmark::State& state, PerfRegion& perf, Op&& op) {
+    perf.resume();
+    const auto t0 = std::chrono::steady_clock::now();
+    op();
+    const auto t1 = std::chrono::steady_clock::now();
+    perf.pause();
+    state.SetIterationTime(std::chrono::duration<double>(t1 - t0).count());
+}
+
+// Resting passive adds, cycling over the existing bid levels; the added
+// orders are cancelled again (untimed) every kBatch adds.
+void BM_AddNoCross(benchmark::State& state) {
+    const int levels = static_cast<int>(state.range(0));
+    Book b(levels, 4);
+    constexpr std::size_t kBatch = 4096;
+    std::vector<OrderId> added;
+    added.reserve(kBatch);
+    int l = 0;
+    PerfRegion perf(state);
+    for (auto _ : state) {
+        const OrderId id = b.next_bid++;
+        benchmark::DoNotOptimize(b.ob.add_limit(id, Side::Buy, kMid - 1 - l, kQty));
+        added.push_back(id);
+        if (++l == levels) l = 0;
+        if (added.size() == kBatch) {
+            state.PauseTiming();
+            perf.pause();
+            for (OrderId a : added) (void)b.ob.cancel(a);
+            added.clear();
+            perf.resume();
+            state.ResumeTiming();
+        }
+    }
+}
+BENCHMARK(BM_AddNoCross)->RangeMultiplier(8)->Range(1, 4096);
+
+// A limit buy that fills one order on each of the best k ask levels.
+void BM_AddCrossing(benchmark::State& state) {
+    const int k = static_cast<int>(state.range(0));
+    Book b(k, 1);
+    OrderId id = 1'000'000;
+    PerfRegion perf(state, false);
+    for (auto _ : state) {
+        timed(state, perf, [&] { benchmark::DoNotOptimize(b.ob.add_limit(id, Side::Buy, kMid + k, k * kQty)); });
+        ++id;
+        b.refill_asks(k);
+    }
+    state.counters["levels"] = k;
+}
+BENCHMARK(BM_AddCrossing)->RangeMultiplier(4)->Range(1, 256)->UseManualTime();
+
+// A market buy sweeping the best k ask levels, in a book 1024 levels deep.
+void BM_MarketSweep(benchmark::State& state) {
+    const int k = static_cast<int>(state.range(0));
+    Book b(1024, 1);
+    OrderId id = 1'000'000;
+    PerfRegion perf(state, false);
+    for (auto _ : state) {
+        timed(state, perf, [&] { benchmark::DoNotOptimize(b.ob.add_market(id, Side::Buy, k * kQty)); });
+        ++id;
+        b.refill_asks(k);
+    }
+}
+BENCHMARK(BM_MarketSweep)->RangeMultiplier(4)->Range(1, 256)->UseManualTime();
+
+// Cancel at the front, middle or back of one queue of `depth` orders; the
+// cancelled order is re-added (untimed) at the back.
+enum class Position { Front, Middle, Back };
+
+template <Position P>
+void BM_Cancel(benchmark::State& state) {
+    const auto depth = static_cast<std::size_t>(state.range(0));
+    OrderBook ob;
+    std::deque<OrderId> queue;
+    OrderId next = 1;
+    for (std::size_t i = 0; i < depth; ++i) {
+        (void)ob.add_limit(next, Side::Buy, kMid, kQty);
+        queue.push_back(next++);
+    }
+    PerfRegion perf(state, false);
+    for (auto _ : state) {
+        const std::size_t pos = P == Position::Front ? 0 : P == Position::Middle ? depth / 2 : depth - 1;
+        timed(state, perf, [&] { benchmark::DoNotOptimize(ob.cancel(queue[pos])); });
+        queue.erase(queue.begin() + static_cast<std::ptrdiff_t>(pos));
+        (void)ob.add_limit(next, Side::Buy, kMid, kQty);
+        queue.push_back(next++);
+    }
+}
+BENCHMARK(BM_Cancel<Position::Front>)->RangeMultiplier(16)->Range(1, 65536)->UseManualTime();
+BENCHMARK(BM_Cancel<Position::Middle>)->RangeMultiplier(16)->Range(1, 65536)->UseManualTime();
+BENCHMARK(BM_Cancel<Position::Back>)->RangeMultiplier(16)->Range(1, 65536)->UseManualTime();
+
+// A market order filling the front order of a queue `depth` orders deep.
+void BM_DeepQueueFill(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+    Book b(1, depth);
+    OrderId id = 1'000'000;
+    PerfRegion perf(state, false);
+    for (auto _ : state) {
+        timed(state, perf, [&] { benchmark::DoNotOptimize(b.ob.add_market(id, Side::Buy, kQty)); });
+        ++id;
+        b.refill_asks(1);
+    }
+}
+BENCHMARK(BM_DeepQueueFill)->RangeMultiplier(16)->Range(1, 65536)->UseManualTime();
+
+// Adding an order at a price of its own (a new level) inside a book of
+// `levels` levels, then cancelling it (the level is removed): the cost of
+// level creation and removal as the book gets wider.
+void BM_WideBookNewLevel(benchmark::State& state) {
+    const int levels = static_cast<int>(state.range(0));
+    Book b(levels, 1);
+    // Gaps between the resting levels, so every add creates a level.
+    OrderBook& ob = b.ob;
+    for (int l = 0; l < levels; ++l) (void)ob.cancel(static_cast<OrderId>(l + 1));
+    for (int l = 0; l < levels; ++l) (void)ob.add_limit(b.next_bid++, Side::Buy, kMid - 2 * (l + 1), kQty);
+    int l = 0;
+    PerfRegion perf(state);
+    for (auto _ : state) {
+        const OrderId id = b.next_bid++;
+        benchmark::DoNotOptimize(ob.add_limit(id, Side::Buy, kMid - 1 - 2 * l, kQty));
+        benchmark::DoNotOptimize(ob.cancel(id));
+        if (++l == levels) l = 0;
+    }
+}
+BENCHMARK(BM_WideBookNewLevel)->RangeMultiplier(8)->Range(1, 32768);
+
+// best_bid() + best_ask() on a book of `levels` levels per side.
+void BM_BestPrices(benchmark::State& state) {
+    Book b(static_cast<int>(state.range(0)), 1);
+    PerfRegion perf(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(b.ob.best_bid());
+        benchmark::DoNotOptimize(b.ob.best_ask());
+    }
+}
+BENCHMARK(BM_BestPrices)->RangeMultiplier(8)->Range(1, 4096);
+
+}  // namespace
@@ -0,0 +1,46 @@
+#pragma once
+
+// Hardware counters for lob_benchmarks (--perf, see bench_main.cpp).
+//
+// A PerfRegion counts while the benchmark's measured operation runs and,
+// when it goes out of scope after the benchmark loop, reports the counts per
+// iteration as user counters (cycles, instructions, l1d_misses, ...) next to
+// the timings. Without --perf it does nothing.
+#include <benchmark/benchmark.h>
+
+#include "perf_counters.hpp"
+
+PerfCounters* bench_perf();  // nullptr unless --perf and the counters opened
+
+class PerfRegion {
+public:
+    // `running`: count from here on (benchmarks timed by the loop itself), or
+    // only between resume() and pause() (manually timed ones).
+    explicit PerfRegion(benchmark::State& state, bool running = true) : state_(state), pc_(bench_perf()) {
+        if (!pc_) return;
+        pc_->reset();
+        if (running) pc_->start();
+    }
+
+    ~PerfRegion() {
+        if (!pc_) return;
+        pc_->stop();
+        const PerfCounters::Counts counts = pc_->read();
+        for (std::size_t e = 0; e < PerfCounters::kEvents; ++e) {
+            const auto ev = static_cast<PerfCounters::Event>(e);
+            if (pc_->available(ev))
+                state_.counters[PerfCounters::name(ev)] =
+                    benchmark::Counter(static_cast<double>(counts[e]), benchmark::Counter::kAvgIterations);
+        }
+    }
+
+    PerfRegion(const PerfRegion&)            = delete;
+    PerfRegion& operator=(const PerfRegion&) = delete;
+
+    void resume() noexcept { if (pc_) pc_->start(); }
+    void pause() noexcept  { if (pc_) pc_->stop(); }
+
+private:
+    benchmark::State& state_;
+    PerfCounters*     pc_;
+};
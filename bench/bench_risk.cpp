@@ -0,0 +1,80 @@
+// Pre-trade risk (risk.hpp): the gate an order passes as the engine runs it
+// (the book's touch() under its shared lock, then RiskEngine::check()) across
+// account populations from cache-resident to well past L2, and the equity
+// workload replayed with and without that gate and the listener in front of
+// the book (compare BM_WorkloadRisk/0 with /1 for the whole per-order
+// overhead, state updates included).
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "bench_perf.hpp"
+#include "command.hpp"
+#include "risk.hpp"
+#include "workload.hpp"
+
+namespace {
+
+constexpr std::size_t kChecks = 4096;
+constexpr std::size_t kOps    = 100'000;
+
+// Loose enough that every check runs to the end without rejecting.
+RiskLimits loose_limits() {
+    return RiskLimits{ 1'000'000, 1'000'000'000'000, 1'000'000, 1'000'000, 1'000'000'000 };
+}
+
+void BM_RiskCheck(benchmark::State& state) {
+    const auto accounts = static_cast<AccountId>(state.range(0));
+    RiskEngine risk(accounts);
+    risk.set_default_limits(loose_limits());
+
+    struct Probe { AccountId account; Side side; std::int64_t price, qty; };
+    std::mt19937_64 rng(42);
+    std::vector<Probe> probes(kChecks);
+    for (auto& p : probes)
+        p = Probe{ static_cast<AccountId>(1 + rng() % accounts), rng() % 2 ? Side::Buy : Side::Sell,
+                   9'950 + static_cast<std::int64_t>(rng() % 100), 1 + static_cast<std::int64_t>(rng() % 100) };
+
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Buy, 9'999, 100);
+    (void)ob.add_limit(2, Side::Sell, 10'001, 100);
+    PerfRegion perf(state);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const Probe& p = probes[i++ % kChecks];
+        const Touch  t = ob.touch();
+        benchmark::DoNotOptimize(risk.check(p.account, p.side, p.price, p.qty, t.bid, t.ask));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+BENCHMARK(BM_RiskCheck)->Arg(16)->Arg(4'096)->Arg(65'535);
+
+void BM_WorkloadRisk(benchmark::State& state) {
+    const bool with_risk = state.range(0) != 0;
+    std::vector<WorkloadOp> ops = WorkloadGenerator(workload_preset("equity")).generate(kOps);
+    for (auto& op : ops) op.cmd.owner = static_cast<AccountId>(1 + op.cmd.id % 1'024);
+
+    PerfRegion perf(state);
+    for (auto _ : state) {
+        OrderBook  ob;
+        RiskEngine risk(1'024);
+        risk.set_default_limits(loose_limits());
+        if (with_risk) ob.set_listener(&risk);
+        for (const WorkloadOp& op : ops) {
+            const Command& c = op.cmd;
+            if (with_risk && (c.type == CommandType::Add || c.type == CommandType::Market)) {
+                const Touch t = ob.touch();
+                if (risk.check(c.owner, c.side, c.type == CommandType::Add ? c.price : 0, c.qty,
+                               t.bid, t.ask) != RiskReject::None)
+                    continue;
+            }
+            benchmark::DoNotOptimize(apply_command(ob, c));
+        }
+        ob.set_listener(nullptr);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kOps));
+}
+BENCHMARK(BM_WorkloadRisk)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+}  // namespace
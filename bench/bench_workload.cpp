@@ -0,0 +1,29 @@
+// Replays generated order flow (workload.hpp) through a fresh book per
+// iteration: blended throughput per preset, to go with the per-operation
+// numbers in bench_order_book.cpp.
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bench_perf.hpp"
+#include "command.hpp"
+#include "workload.hpp"
+
+namespace {
+
+constexpr std::size_t kOps = 100'000;
+
+void BM_Workload(benchmark::State& state, const char* preset) {
+    const std::vector<WorkloadOp> ops = WorkloadGenerator(workload_preset(preset)).generate(kOps);
+    PerfRegion perf(state);
+    for (auto _ : state) {
+        OrderBook ob;
+        for (const WorkloadOp& op : ops) benchmark::DoNotOptimize(apply_command(ob, op.cmd));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kOps));
+}
+BENCHMARK_CAPTURE(BM_Workload, uniform, "uniform")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Workload, equity, "equity")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Workload, futures, "futures")->Unit(benchmark::kMillisecond);
+
+}  // namespace
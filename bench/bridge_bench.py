@@ -0,0 +1,303 @@
+"""
+bridge_bench.py — end-to-end benchmark of the Python bridge to the C++ engine.
+
+Launches `lob` through LOBEngine (ShmEngine with --transport shm) and drives
+it with C concurrent asyncio clients, either straight through the bridge
+(--mode bridge) or through the FastAPI app over HTTP (--mode rest: uvicorn
+serves api.main:app in this process, with the market feed off, and the HTTP
+clients run in a child process so they don't share an event loop with the
+server). Each client sends its own pre-generated flow of limit adds, cancels
+and market orders (70/20/10, like `lob --bench`) back to back, so C is also
+the number of orders in flight.
+
+For every concurrency level it prints throughput and latency percentiles per
+stage of an order's path, and the stage's share of the mean total:
+
+  http       HTTP round trip minus the bridge call (rest only)
+  lock_wait  waiting for the in-flight window and the pipe write lock
+  write      writing the command (pipe write + drain, or ring push)
+  engine     command written → reply handed back (engine, stdout pipe, reader
+             task; under load mostly queueing behind earlier commands)
+  parse      reply → models
+  total      the whole order as the client sees it
+
+and finally the highest throughput whose p99 total stays within --slo-ms
+(any level if no SLO is given). The engine is restarted for every level.
+
+  python bench/bridge_bench.py --mode bridge --concurrency 1,8,64 --orders 20000
+  python bench/bridge_bench.py --mode rest --concurrency 1,8,64 --orders 5000
+"""
+from __future__ import annotations
+
+import argparse
+import asyncio
+import math
+import multiprocessing
+import os
+import random
+import sys
+import time
+from dataclasses import dataclass, field
+from typing import Optional
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+_MID = 10_000
+_ID_STRIDE = 1_000_000_000   # client c uses order ids (c + 1) * _ID_STRIDE + k
+_STAGES = ("http", "lock_wait", "write", "engine", "parse", "total")
+
+Order = tuple[str, tuple]    # ("limit" | "market" | "cancel", engine call arguments)
+
+
+def make_orders(client: int, n: int, seed: int) -> list[Order]:
+    """Client `client`'s flow: passive limits within 10 ticks of the mid,
+    cancels of its own earlier limits (possibly filled by then) and small
+    market orders."""
+    rng = random.Random(seed * 1_000_003 + client)
+    next_id = (client + 1) * _ID_STRIDE
+    live: list[int] = []
+    orders: list[Order] = []
+    for _ in range(n):
+        r = rng.random()
+        side = "BUY" if rng.random() < 0.5 else "SELL"
+        if r < 0.2 and live:
+            orders.append(("cancel", (live.pop(rng.randrange(len(live))),)))
+            continue
+        next_id += 1
+        if r < 0.3:
+            orders.append(("market", (next_id, side, rng.randint(1, 5))))
+        else:
+            offset = rng.randint(1, 10)
+            price = _MID - offset if side == "BUY" else _MID + offset
+            orders.append(("limit", (next_id, side, price, rng.randint(1, 10))))
+            live.append(next_id)
+    return orders
+
+
+@dataclass
+class LevelResult:
+    clients: int
+    orders: int
+    errors: int
+    seconds: float
+    stages: dict[str, list[float]] = field(default_factory=dict)
+
+    @property
+    def orders_per_sec(self) -> float:
+        return self.orders / self.seconds if self.seconds > 0 else 0.0
+
+
+def percentile(sorted_values: list[float], p: float) -> float:
+    if not sorted_values:
+        return 0.0
+    rank = max(1, math.ceil(p / 100.0 * len(sorted_values)))   # nearest rank
+    return sorted_values[min(rank, len(sorted_values)) - 1]
+
+
+def report(mode: str, transport: str, r: LevelResult) -> None:
+    print(f"BRIDGE mode={mode} transport={transport} clients={r.clients} orders={r.orders} "
+          f"errors={r.errors} seconds={r.seconds:.3f} orders_per_sec={r.orders_per_sec:.0f}")
+    totals = r.stages.get("total", [])
+    mean_total = sum(totals) / len(totals) if totals else 0.0
+    for stage in _STAGES:
+        values = sorted(r.stages.get(stage, []))
+        if not values:
+            continue
+        mean = sum(values) / len(values)
+        us = lambda s: f"{s * 1e6:.1f}"
+        print(f"BRIDGE_STAGE clients={r.clients} stage={stage} mean_us={us(mean)} "
+              f"p50_us={us(percentile(values, 50))} p99_us={us(percentile(values, 99))} "
+              f"p99.9_us={us(percentile(values, 99.9))} max_us={us(values[-1])} "
+              f"share={mean / mean_total if mean_total else 0.0:.2f}")
+    sys.stdout.flush()
+
+
+# ── bridge mode ───────────────────────────────────────────────────────────────
+
+async def run_bridge(engine, flows: list[list[Order]]) -> LevelResult:
+    from api.engine import EngineError
+
+    engine.stage_times = {}
+    await engine.start()
+    calls = {"limit": engine.add_limit, "market": engine.add_market, "cancel": engine.cancel}
+    totals: list[float] = []
+    errors = 0
+
+    async def client(orders: list[Order]) -> None:
+        nonlocal errors
+        for op, args in orders:
+            t0 = time.perf_counter()
+            try:
+                await calls[op](*args)
+            except EngineError:
+                errors += 1
+            totals.append(time.perf_counter() - t0)
+
+    try:
+        t0 = time.perf_counter()
+        await asyncio.gather(*(client(orders) for orders in flows))
+        seconds = time.perf_counter() - t0
+    finally:
+        await engine.stop()
+
+    stages, engine.stage_times = engine.stage_times, None
+    stages["total"] = totals
+    return LevelResult(len(flows), len(totals), errors, seconds, stages)
+
+
+# ── REST mode ─────────────────────────────────────────────────────────────────
+
+def _rest_worker(url: str, flows: list[list[Order]], conn) -> None:
+    """Child process: runs the HTTP clients, sends back (samples, errors, seconds)."""
+    conn.send(asyncio.run(_rest_clients(url, flows)))
+    conn.close()
+
+
+async def _rest_clients(url: str, flows: list[list[Order]]):
+    import httpx
+
+    samples: list[tuple[str, int, float]] = []   # (op, order id, seconds)
+    errors = 0
+    limits = httpx.Limits(max_connections=len(flows), max_keepalive_connections=len(flows))
+    async with httpx.AsyncClient(base_url=url, limits=limits, timeout=30.0) as http:
+
+        async def client(orders: list[Order]) -> None:
+            nonlocal errors
+            for op, args in orders:
+                if op == "limit":
+                    oid, side, price, qty = args
+                    request = http.post("/orders/limit",
+                                        json={"order_id": oid, "side": side, "price": price, "qty": qty})
+                elif op == "market":
+                    oid, side, qty = args
+                    request = http.post("/orders/market", json={"order_id": oid, "side": side, "qty": qty})
+                else:
+                    oid, = args
+                    request = http.delete(f"/orders/{oid}")
+                t0 = time.perf_counter()
+                response = await request
+                samples.append((op, oid, time.perf_counter() - t0))
+                if response.status_code != 200:
+                    errors += 1
+
+        # One request per connection first, so connection setup stays untimed.
+        await asyncio.gather(*(http.get("/health") for _ in flows))
+        t0 = time.perf_counter()
+        await asyncio.gather(*(client(orders) for orders in flows))
+        seconds = time.perf_counter() - t0
+    return samples, errors, seconds
+
+
+def _time_bridge_calls(engine, into: dict[tuple[str, int], float]) -> None:
+    """Wraps the engine's order calls to record each call's duration by (op, order id)."""
+    for op, name in (("limit", "add_limit"), ("market", "add_market"), ("cancel", "cancel")):
+        call = getattr(engine, name)
+
+        async def timed(order_id, *args, _op=op, _call=call):
+            t0 = time.perf_counter()
+            try:
+                return await _call(order_id, *args)
+            finally:
+                into[(_op, order_id)] = time.perf_counter() - t0
+
+        setattr(engine, name, timed)
+
+
+async def run_rest(server, bridge: dict[tuple[str, int], float], port: int,
+                   flows: list[list[Order]]) -> LevelResult:
+    import uvicorn
+
+    bridge.clear()
+    server.engine.stage_times = {}
+
+    uv = uvicorn.Server(uvicorn.Config(server.app, host="127.0.0.1", port=port,
+                                       log_level="warning", lifespan="on"))
+    serving = asyncio.create_task(uv.serve())
+    while not uv.started:
+        if serving.done():
+            await serving   # surfaces the startup error
+            raise RuntimeError("uvicorn exited during startup")
+        await asyncio.sleep(0.01)
+
+    ctx = multiprocessing.get_context("spawn")
+    recv, send = ctx.Pipe(duplex=False)
+    worker = ctx.Process(target=_rest_worker, args=(f"http://127.0.0.1:{port}", flows, send))
+    try:
+        worker.start()
+        send.close()
+        samples, errors, seconds = await asyncio.get_running_loop().run_in_executor(None, recv.recv)
+    finally:
+        worker.join()
+        uv.should_exit = True
+        await serving
+
+    stages, server.engine.stage_times = server.engine.stage_times, None
+    stages["total"] = [dt for _, _, dt in samples]
+    stages["http"] = [dt - bridge[(op, oid)] for op, oid, dt in samples if (op, oid) in bridge]
+    return LevelResult(len(flows), len(samples), errors, seconds, stages)
+
+
+# ── main ──────────────────────────────────────────────────────────────────────
+
+async def main_async(args) -> int:
+    levels = [int(c) for c in args.concurrency.split(",") if c]
+    if not levels or min(levels) <= 0:
+        raise SystemExit("--concurrency needs positive client counts")
+
+    if args.mode == "rest":
+        import api.main as server
+        bridge: dict[tuple[str, int], float] = {}
+        _time_bridge_calls(server.engine, bridge)
+    else:
+        from api.engine import LOBEngine
+        from api.shm_client import ShmEngine
+
+    results: list[LevelResult] = []
+    for clients in levels:
+        per_client = max(1, args.orders // clients)
+        flows = [make_orders(c, per_client, args.seed) for c in range(clients)]
+        if args.mode == "rest":
+            r = await run_rest(server, bridge, args.port, flows)
+        else:
+            engine = ShmEngine() if args.transport == "shm" else LOBEngine()
+            r = await run_bridge(engine, flows)
+        report(args.mode, args.transport, r)
+        results.append(r)
+
+    def p99_ms(r: LevelResult) -> float:
+        return percentile(sorted(r.stages["total"]), 99) * 1e3
+
+    ok = [r for r in results if args.slo_ms is None or p99_ms(r) <= args.slo_ms]
+    best: Optional[LevelResult] = max(ok, key=lambda r: r.orders_per_sec, default=None)
+    slo = f"{args.slo_ms:g}" if args.slo_ms is not None else "none"
+    if best is None:
+        print(f"BRIDGE_RESULT sustainable_orders_per_sec=0 clients=none slo_ms={slo}")
+    else:
+        print(f"BRIDGE_RESULT sustainable_orders_per_sec={best.orders_per_sec:.0f} "
+              f"clients={best.clients} p99_ms={p99_ms(best):.3f} slo_ms={slo}")
+    return 0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip(),
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--mode", choices=("bridge", "rest"), default="bridge")
+    parser.add_argument("--transport", choices=("pipe", "shm"), default="pipe")
+    parser.add_argument("--concurrency", default="1,8,64", help="comma-separated client counts")
+    parser.add_argument("--orders", type=int, default=20_000, help="orders per concurrency level")
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument("--slo-ms", type=float, default=None, help="p99 bound for the sustainable rate")
+    parser.add_argument("--port", type=int, default=8765, help="uvicorn port (rest mode)")
+    parser.add_argument("--binary", help="lob binary (default: LOB_BINARY or build/lob)")
+    args = parser.parse_args()
+
+    # Read by the api package at import time.
+    if args.binary:
+        os.environ["LOB_BINARY"] = args.binary
+    os.environ["LOB_TRANSPORT"] = args.transport
+    os.environ["LOB_MARKET_FEED"] = "0"
+    return asyncio.run(main_async(args))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,209 @@
+// lob_contention — how one OrderBook behaves under concurrent access.
+//
+// Runs W writer threads, each replaying its own generated order flow
+// (workload.hpp), against one book while R reader threads poll
+// best_bid()/best_ask(), and reports writer throughput, per-operation writer
+// latency and reader throughput for every combination of W, R and lock
+// policy:
+//
+//   shared_mutex  the book's own locking (readers share, writers exclude)
+//   mutex         every call also under one std::mutex
+//   spin          every call also under a test-and-test-and-set spinlock
+//   sharded       no sharing: one book per writer, readers poll all of them
+//
+// The alternative policies wrap the book, whose internal shared_mutex is then
+// never contended; its uncontended cost is the same in every row.
+//
+//   lob_contention [--ops N] [--writers 1,2,4] [--readers 0,1,4]
+//                  [--policies shared_mutex,mutex,spin,sharded] [--workload <preset|file>]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "command.hpp"
+#include "latency.hpp"
+#include "workload.hpp"
+
+namespace {
+
+class SpinLock {
+public:
+    void lock() noexcept {
+        for (;;) {
+            if (!flag_.exchange(true, std::memory_order_acquire)) return;
+            while (flag_.load(std::memory_order_relaxed)) {
+#if defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#else
+                std::this_thread::yield();
+#endif
+            }
+        }
+    }
+    void unlock() noexcept { flag_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> flag_{false};
+};
+
+struct NoLock {
+    void lock() noexcept {}
+    void unlock() noexcept {}
+};
+
+struct Result {
+    double           writer_ops_per_sec = 0;
+    double           reads_per_sec      = 0;
+    LatencyHistogram latency;
+};
+
+// `Lock` guards every call; with `sharded`, writer w owns book w.
+template <typename Lock>
+Result run(const std::vector<std::vector<WorkloadOp>>& streams, unsigned readers, bool sharded) {
+    const std::size_t writers = streams.size();
+    std::vector<std::unique_ptr<OrderBook>> books(sharded ? writers : 1);
+    for (auto& b : books) b = std::make_unique<OrderBook>();
+    Lock lock;
+
+    std::atomic<bool>     go{false};
+    std::atomic<unsigned> writers_left{static_cast<unsigned>(writers)};
+    std::vector<LatencyHistogram> lat(writers);
+    std::vector<std::uint64_t>    reads(readers);
+
+    std::vector<std::thread> threads;
+    for (std::size_t w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w] {
+            OrderBook& ob = *books[sharded ? w : 0];
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (const WorkloadOp& op : streams[w]) {
+                const std::uint64_t t0 = CycleClock::now();
+                lock.lock();
+                (void)apply_command(ob, op.cmd);
+                lock.unlock();
+                lat[w].record(CycleClock::now() - t0);
+            }
+            writers_left.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    for (unsigned r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            std::uint64_t n = 0, sink = 0;
+            std::size_t   b = r % books.size();
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (writers_left.load(std::memory_order_acquire) > 0) {
+                lock.lock();
+                const auto bid = books[b]->best_bid();
+                const auto ask = books[b]->best_ask();
+                lock.unlock();
+                sink += static_cast<std::uint64_t>(bid.value_or(0) ^ ask.value_or(0));  // keeps the reads alive
+                ++n;
+                if (++b == books.size()) b = 0;
+            }
+            reads[r] = n + (sink == 42);
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Result res;
+    std::uint64_t ops = 0, total_reads = 0;
+    for (const auto& s : streams) ops += s.size();
+    for (auto n : reads) total_reads += n;
+    for (const auto& h : lat) res.latency.merge(h);
+    res.writer_ops_per_sec = static_cast<double>(ops) / sec;
+    res.reads_per_sec      = static_cast<double>(total_reads) / sec;
+    return res;
+}
+
+std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    for (std::string item; std::getline(ss, item, ',');) if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+std::vector<unsigned> split_counts(const std::string& s) {
+    std::vector<unsigned> out;
+    for (const auto& item : split(s)) out.push_back(static_cast<unsigned>(std::stoul(item)));
+    return out;
+}
+
+int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--ops N] [--writers 1,2,4] [--readers 0,1,4]\n"
+              << "       [--policies shared_mutex,mutex,spin,sharded] [--workload <preset|file>]\n";
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t ops = 200'000;  // per writer
+    std::vector<unsigned> writer_counts{ 1, 2, 4 }, reader_counts{ 0, 1, 4 };
+    std::vector<std::string> policies{ "shared_mutex", "mutex", "spin", "sharded" };
+    std::string workload = "equity";
+    try {
+        for (int i = 1; i < argc; i += 2) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) return usage(argv[0]);
+            const std::string val = argv[i + 1];
+            if      (arg == "--ops")      ops = std::stoull(val);
+            else if (arg == "--writers")  writer_counts = split_counts(val);
+            else if (arg == "--readers")  reader_counts = split_counts(val);
+            else if (arg == "--policies") policies = split(val);
+            else if (arg == "--workload") workload = val;
+            else return usage(argv[0]);
+        }
+
+        const WorkloadConfig base = resolve_workload(workload);
+        (void)CycleClock::ns_per_tick();
+        std::cout << "# hardware threads: " << std::thread::hardware_concurrency() << "\n";
+
+        for (unsigned writers : writer_counts) {
+            if (writers == 0) throw std::invalid_argument("--writers counts must be > 0");
+            // One stream per writer, each with its own seed and id range.
+            std::vector<std::vector<WorkloadOp>> streams;
+            for (unsigned w = 0; w < writers; ++w) {
+                WorkloadConfig cfg = base;
+                cfg.seed = base.seed + w;
+                streams.push_back(WorkloadGenerator(cfg).generate(ops));
+                for (auto& op : streams.back()) op.cmd.id += static_cast<OrderId>(w) << 40;
+            }
+            for (unsigned readers : reader_counts) {
+                for (const auto& policy : policies) {
+                    Result r;
+                    if      (policy == "shared_mutex") r = run<NoLock>(streams, readers, false);
+                    else if (policy == "mutex")        r = run<std::mutex>(streams, readers, false);
+                    else if (policy == "spin")         r = run<SpinLock>(streams, readers, false);
+                    else if (policy == "sharded")      r = run<NoLock>(streams, readers, true);
+                    else throw std::invalid_argument("Unknown policy: " + policy);
+
+                    auto ns = [](std::uint64_t t) { return CycleClock::to_ns(t); };
+                    std::cout << "CONTENTION policy=" << policy << " writers=" << writers << " readers=" << readers
+                              << " writer_ops_per_sec=" << static_cast<std::uint64_t>(r.writer_ops_per_sec)
+                              << " reads_per_sec=" << static_cast<std::uint64_t>(r.reads_per_sec)
+                              << " p50_ns=" << ns(r.latency.percentile(50)) << " p99_ns=" << ns(r.latency.percentile(99))
+                              << " p99.9_ns=" << ns(r.latency.percentile(99.9)) << " max_ns=" << ns(r.latency.max()) << "\n";
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
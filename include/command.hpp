@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "order_book.hpp"
+
+enum class CommandType : std::uint8_t { Add = 1, Market = 2, Cancel = 3, Status = 4, Depth = 5 };
+
+// Fixed-size binary form of one engine command (the text protocol's
+// ADD / MARKET / CANCEL / STATUS / DEPTH). Trivially copyable so it can be written
+// straight into shared memory and files. `stp` and `owner` took over bytes
+// that used to be zero padding, so older journals read as anonymous orders.
+struct Command {
+    OrderId       id;     // unused for Status / Depth
+    std::int64_t  price;  // Add only
+    std::int64_t  qty;    // Add / Market; levels per side for Depth
+    CommandType   type;
+    Side          side;   // Add / Market
+    StpMode       stp   = StpMode::CancelNewest;  // Add / Market
+    std::uint8_t  pad   = 0;
+    AccountId     owner = 0;                      // Add / Market; 0 = anonymous
+};
+
+static_assert(sizeof(Command) == 32, "Command is part of on-disk / shared-memory layouts");
+static_assert(offsetof(Command, owner) == 28);
+static_assert(std::is_trivially_copyable_v<Command>);
+
+// Applies a command to `ob` exactly as the interactive loop does and returns
+// the trades it generated. Cancel of an unknown id, Status and Depth are
+// no-ops. Throws std::invalid_argument for a side or STP mode out of range.
+std::vector<Trade> apply_command(OrderBook& ob, const Command& cmd);
+
+// Parses one line of the text command format used by replay files
+// ("ADD <id> BUY|SELL <price> <qty>", "MARKET <id> BUY|SELL <qty>",
+// "CANCEL <id>", "STATUS", "DEPTH <n>"). ADD and MARKET take optional
+// trailing "OWNER <account>" and "STP <mode>" (parse_order_options). Blank and
+// '#' comment lines yield nullopt; anything else malformed throws
+// std::invalid_argument.
+std::optional<Command> parse_command(std::string_view line);
+
+// Parses the optional "OWNER <account>" / "STP CANCEL_NEWEST|CANCEL_OLDEST|
+// CANCEL_BOTH|DECREMENT" words after an ADD / MARKET into `cmd`; anything
+// else left on the line throws std::invalid_argument.
+void parse_order_options(std::string_view rest, Command& cmd);
+
+const char* stp_name(StpMode mode);
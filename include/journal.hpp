@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command.hpp"
+
+// ── Write-ahead command journal ───────────────────────────────────────────────
+//
+// Append-only binary log of every accepted command. Replaying it into an
+// empty OrderBook rebuilds the exact book (same resting orders, same
+// priority). File layout:
+//
+//   header  16 bytes   magic "LOBJRNL1", u32 version = 1, u32 record size = 48
+//   records 48 bytes   JournalRecord, lsn = 1, 2, 3, ...
+//
+// A crash can leave a torn last record; readers stop at the first record
+// whose checksum or lsn doesn't match, and the writer truncates it away.
+
+enum class Durability : std::uint8_t {
+    None,   // committed batches go to the page cache; survives a process crash only
+    Async,  // as None, plus a background thread fdatasync()s every `sync_interval`
+    Sync,   // every committed batch is fdatasync()ed before commit() returns
+};
+
+struct JournalOptions {
+    Durability                durability     = Durability::Async;
+    std::size_t               batch_records  = 4096;                           // commit when this many are pending
+    std::chrono::microseconds batch_interval = std::chrono::microseconds(500); // ... or the oldest is this old
+    std::chrono::microseconds sync_interval  = std::chrono::microseconds(2000); // Async flusher period
+};
+
+struct JournalRecord {
+    std::uint64_t lsn;       // log sequence number, dense from 1
+    Command       cmd;
+    std::uint64_t checksum;  // FNV-1a over lsn and cmd
+};
+
+static_assert(sizeof(JournalRecord) == 48, "JournalRecord is an on-disk layout");
+
+[[nodiscard]] std::uint64_t journal_checksum(const JournalRecord& rec);
+
+// True if `path` starts with a journal header (vs. e.g. a text command file).
+[[nodiscard]] bool is_journal_file(const std::string& path);
+
+class JournalReader {
+public:
+    explicit JournalReader(const std::string& path);  // throws if unreadable / bad header
+    ~JournalReader();
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    // False at end of file or at the first torn / corrupt record.
+    [[nodiscard]] bool next(JournalRecord& out);
+
+    // Positions the reader so the next record returned is lsn + 1. Records
+    // are fixed-size and lsns dense, so this is a single seek.
+    void skip_to(std::uint64_t lsn);
+
+    // Byte length of the valid prefix read so far (header included).
+    [[nodiscard]] std::uint64_t valid_bytes() const { return valid_bytes_; }
+    [[nodiscard]] std::uint64_t last_lsn() const { return last_lsn_; }
+
+private:
+    std::FILE*    f_;
+    std::uint64_t valid_bytes_;
+    std::uint64_t last_lsn_ = 0;
+};
+
+// Group-commit writer. append() only buffers; records reach the file in
+// batches when commit() is called or a batch threshold is crossed.
+// Single-threaded use (the engine thread); the Async flusher is internal.
+class JournalWriter {
+public:
+    // Opens (or creates) `path` for appending after its last valid record.
+    JournalWriter(const std::string& path, JournalOptions opts = {});
+    ~JournalWriter();  // commits what is pending
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    // Buffers one accepted command and returns its lsn. May commit.
+    std::uint64_t append(const Command& cmd);
+
+    // Writes every pending record; with Durability::Sync also fdatasync()s.
+    void commit();
+
+    // fdatasync()s what has been committed so far. Safe to call from another
+    // thread (the snapshot writer) while the engine thread keeps appending.
+    void sync_to_disk();
+
+    [[nodiscard]] std::uint64_t last_lsn() const { return next_lsn_ - 1; }
+
+private:
+    void flusher_loop();
+
+    int                   fd_;
+    JournalOptions        opts_;
+    std::uint64_t         next_lsn_;
+    std::vector<JournalRecord> pending_;
+    std::chrono::steady_clock::time_point oldest_pending_;
+
+    // Async mode: commit() marks the file dirty, the flusher syncs it.
+    std::mutex              sync_mtx_;
+    std::condition_variable sync_cv_;
+    bool                    dirty_    = false;
+    bool                    stopping_ = false;
+    std::thread             flusher_;
+};
+
+// Applies every valid record after `after_lsn` of the journal at `path` to
+// `ob`. Returns the last lsn applied (`after_lsn` if there were none).
+std::uint64_t replay_journal(const std::string& path, OrderBook& ob, std::uint64_t after_lsn = 0);
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// ── Latency measurement ───────────────────────────────────────────────────────
+//
+// CycleClock reads the TSC (steady_clock elsewhere); LatencyHistogram records
+// every sample into fixed log-linear buckets, HdrHistogram style. Recording
+// is a bucket index computation and three stores: no allocation, no locks,
+// cheap enough to time every operation of the production engine. A histogram
+// has a single writer; merge() combines per-thread histograms afterwards.
+
+struct CycleClock {
+    // Raw ticks; only differences are meaningful.
+    static std::uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // Nanoseconds per tick, calibrated against steady_clock once (~10 ms) on
+    // first use. Assumes an invariant TSC, as on every current x86-64 CPU.
+    static double ns_per_tick() {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+    static std::uint64_t to_ns(std::uint64_t ticks) {
+        return static_cast<std::uint64_t>(static_cast<double>(ticks) * ns_per_tick());
+    }
+
+private:
+    static double calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+        using namespace std::chrono;
+        const auto t0 = steady_clock::now();
+        const std::uint64_t c0 = now();
+        std::this_thread::sleep_for(milliseconds(10));
+        const auto t1 = steady_clock::now();
+        const std::uint64_t c1 = now();
+        return static_cast<double>(duration_cast<nanoseconds>(t1 - t0).count()) / static_cast<double>(c1 - c0);
+#else
+        using period = std::chrono::steady_clock::period;
+        return 1e9 * period::num / period::den;
+#endif
+    }
+};
+
+class LatencyHistogram {
+public:
+    // Values below 2^kSubBits have a bucket each; above, every power of two
+    // is split into 2^(kSubBits-1) buckets, so a recorded value is off by at
+    // most 1/64 (1.6%) of itself. Covers the whole uint64 range.
+    static constexpr unsigned    kSubBits  = 7;
+    static constexpr std::size_t kBuckets  = (1u << kSubBits) + (64 - kSubBits) * (1u << (kSubBits - 1));
+
+    void record(std::uint64_t v) noexcept {
+        ++counts_[index(v)];
+        ++total_;
+        sum_ += v;
+        if (v > max_) max_ = v;
+        if (v < min_) min_ = v;
+    }
+
+    void merge(const LatencyHistogram& o) noexcept {
+        for (std::size_t i = 0; i < kBuckets; ++i) counts_[i] += o.counts_[i];
+        total_ += o.total_;
+        sum_   += o.sum_;
+        if (o.max_ > max_) max_ = o.max_;
+        if (o.min_ < min_) min_ = o.min_;
+    }
+
+    void reset() noexcept { *this = LatencyHistogram{}; }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return total_; }
+    [[nodiscard]] std::uint64_t max() const noexcept   { return max_; }
+    [[nodiscard]] std::uint64_t min() const noexcept   { return total_ ? min_ : 0; }
+    [[nodiscard]] double        mean() const noexcept  { return total_ ? static_cast<double>(sum_) / static_cast<double>(total_) : 0.0; }
+
+    // Smallest recorded value v such that `p` percent of samples are <= v,
+    // reported as the upper end of its bucket (never above max()).
+    [[nodiscard]] std::uint64_t percentile(double p) const noexcept {
+        if (total_ == 0) return 0;
+        const auto rank = static_cast<std::uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total_)));
+        const std::uint64_t target = rank == 0 ? 1 : rank;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+            if (seen >= target) return std::min(upper_bound(i), max_);
+        }
+        return max_;
+    }
+
+    // Writes the percentile distribution in HdrHistogram's text format
+    // (Value, Percentile, TotalCount, 1/(1-Percentile)), which its plotting
+    // tools read directly. Values are divided by `unit` (e.g. 1000 for us
+    // from ns); percentiles step 5 ticks per halving of the remaining tail.
+    void write_percentiles(std::ostream& out, double unit = 1.0) const {
+        out << std::setw(12) << "Value" << ' ' << std::setw(14) << "Percentile" << ' '
+            << std::setw(10) << "TotalCount" << ' ' << std::setw(14) << "1/(1-Percentile)" << "\n\n";
+        out << std::fixed;
+        auto line = [&](double p) {
+            const std::uint64_t v = percentile(p * 100.0);
+            std::uint64_t below = 0;
+            for (std::size_t i = 0; i < kBuckets && lower_bound(i) <= v; ++i) below += counts_[i];
+            out << std::setw(12) << std::setprecision(3) << static_cast<double>(v) / unit << ' '
+                << std::setw(14) << std::setprecision(12) << p << ' '
+                << std::setw(10) << below << ' ';
+            if (p < 1.0) out << std::setw(14) << std::setprecision(2) << 1.0 / (1.0 - p);
+            out << "\n";
+        };
+        if (total_ > 0) {
+            for (int half = 0; std::ldexp(1.0, -half) * static_cast<double>(total_) >= 1.0; ++half) {
+                const double base  = 1.0 - std::ldexp(1.0, -half);
+                const double width = std::ldexp(1.0, -half - 1);
+                for (int tick = 0; tick < 5; ++tick) line(base + width * tick / 5.0);
+            }
+            line(1.0);
+        }
+        out << "#[Mean    = " << std::setw(12) << std::setprecision(3) << mean() / unit
+            << ", Max            = " << std::setw(12) << static_cast<double>(max_) / unit << "]\n"
+            << "#[Total count    = " << std::setw(12) << total_
+            << ", Buckets        = " << std::setw(12) << kBuckets << "]\n";
+        out << std::defaultfloat;
+    }
+
+    static constexpr std::size_t index(std::uint64_t v) noexcept {
+        constexpr std::uint64_t sub = 1u << kSubBits;
+        if (v < sub) return static_cast<std::size_t>(v);
+        const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - kSubBits;  // >= 1
+        return static_cast<std::size_t>(sub + (shift - 1) * (sub / 2) + ((v >> shift) - sub / 2));
+    }
+
+    static constexpr std::uint64_t lower_bound(std::size_t i) noexcept {
+        constexpr std::uint64_t sub = 1u << kSubBits;
+        if (i < sub) return i;
+        const std::uint64_t shift = (i - sub) / (sub / 2) + 1;
+        return ((i - sub) % (sub / 2) + sub / 2) << shift;
+    }
+
+    static constexpr std::uint64_t upper_bound(std::size_t i) noexcept {
+        return i + 1 < kBuckets ? lower_bound(i + 1) - 1 : UINT64_MAX;
+    }
+
+private:
+    std::array<std::uint64_t, kBuckets> counts_{};
+    std::uint64_t total_ = 0;
+    std::uint64_t sum_   = 0;
+    std::uint64_t max_   = 0;
+    std::uint64_t min_   = UINT64_MAX;
+};
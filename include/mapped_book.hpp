@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "order_book.hpp"
+
+// ── Memory-mapped book snapshots ──────────────────────────────────────────────
+//
+// A second snapshot encoding meant to be mmap()ed and queried in place by
+// read-only consumers (research, replays, the dashboard backend) without
+// building an OrderBook. Every section is an array of fixed-size records and
+// links are array indices, so opening a file costs one mmap plus a header
+// check, however many orders it holds. Layout (little-endian, 8-byte aligned):
+//
+//   offset  size  field
+//   0       8     magic               "LOBMAP01"
+//   8       4     version             3
+//   12      4     order_record_size   40 (MappedOrder)
+//   16      4     level_record_size   32 (MappedLevel)
+//   20      4     reserved
+//   24      8     lsn                 journal position the book reflects
+//   32      8     next_seq
+//   40      8     bid_levels
+//   48      8     ask_levels
+//   56      8     order_count
+//   64      8     trade_hash          BookHash::trades / trade_count at capture,
+//   72      8     trade_count         so a restored book continues the chain
+//   80      8     event_seq           last OrderEvent sequence number (L3 feed)
+//   88      ...   levels              bids best-first, then asks best-first
+//   ...     ...   orders              grouped by level, FIFO within a level
+//   ...     ...   id index            u64 order positions sorted by order id
+//
+// Unlike the streamed format (snapshot.hpp) there is no checksum: verifying
+// one would mean touching every page, which is what this format avoids.
+
+struct MappedLevel {
+    std::int64_t  price;
+    std::int64_t  total_qty;  // sum of the level's resting quantity
+    std::uint64_t first;      // index of the level's first order in the orders array
+    std::uint64_t count;      // number of orders at the level
+};
+
+struct MappedOrder {
+    OrderId       id;
+    std::int64_t  price;
+    std::int64_t  qty;
+    std::uint64_t seq;
+    Side          side;
+    std::uint8_t  pad[3];
+    AccountId     owner;
+};
+
+static_assert(sizeof(MappedLevel) == 32 && sizeof(MappedOrder) == 40, "mapped snapshot layout");
+
+void write_mapped_snapshot(std::ostream& out, const BookImage& image);
+void write_mapped_snapshot_file(const std::string& path, const BookImage& image);  // durable, see snapshot.hpp
+
+// Read-only view of a mapped snapshot file. Throws std::runtime_error /
+// std::system_error if the file can't be mapped or its header and section
+// sizes are inconsistent.
+class MappedBook {
+public:
+    explicit MappedBook(const std::string& path);
+    MappedBook(MappedBook&& other) noexcept;
+    MappedBook& operator=(MappedBook&&) = delete;
+    MappedBook(const MappedBook&) = delete;
+    ~MappedBook();
+
+    [[nodiscard]] std::uint64_t lsn() const;
+    [[nodiscard]] std::uint64_t next_seq() const;
+
+    [[nodiscard]] std::span<const MappedLevel> bids() const { return bids_; }
+    [[nodiscard]] std::span<const MappedLevel> asks() const { return asks_; }
+    [[nodiscard]] std::span<const MappedOrder> orders() const { return orders_; }
+    [[nodiscard]] std::span<const MappedOrder> orders(const MappedLevel& level) const;
+
+    [[nodiscard]] std::optional<std::int64_t> best_bid() const;
+    [[nodiscard]] std::optional<std::int64_t> best_ask() const;
+
+    // Binary search over the id index; nullptr if the order isn't resting.
+    [[nodiscard]] const MappedOrder* find(OrderId id) const;
+
+    // Materialises the snapshot, e.g. to restore an OrderBook from it.
+    [[nodiscard]] BookImage image() const;
+
+private:
+    const std::byte*               base_ = nullptr;
+    std::size_t                    size_ = 0;
+    std::span<const MappedLevel>   bids_;
+    std::span<const MappedLevel>   asks_;
+    std::span<const MappedOrder>   orders_;
+    std::span<const std::uint64_t> by_id_;
+};
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <functional>
+#include <iosfwd>
 #include <list>
 #include <cstdint>
 #include <map>
@@ -14,9 +16,25 @@ enum class Side : uint8_t { Buy, Sell };
 
 using OrderId = std::uint64_t;
 
+// Participant an order belongs to; 0 = anonymous (never self-trade checked).
+using AccountId = std::uint32_t;
+
+enum class TraceOp : std::uint8_t;  // trace.hpp
+
+// What the matching loop does when an order would trade against a resting
+// order of the same (non-zero) owner. Chosen by the incoming order.
+enum class StpMode : std::uint8_t {
+    CancelNewest = 0,  // drop the incoming order's remaining qty; stop matching
+    CancelOldest = 1,  // cancel the resting order; keep matching
+    CancelBoth   = 2,  // both of the above
+    Decrement    = 3,  // reduce both by the smaller qty without a trade;
+                       // whichever reaches 0 is gone
+};
+
 struct Order {
     OrderId      id;
     Side         side;
+    AccountId    owner;  // fits the padding after `side`
     std::int64_t price;  // limit price; 0 = market
     std::int64_t qty;    // remaining quantity
     std::uint64_t seq;   // monotone sequence for time-priority
@@ -29,15 +47,136 @@ struct Trade {
     OrderId      sell_id;
 };
 
+// Price levels a command filled against (trace records, SLOWLOG). Levels it
+// only walked through self-trade prevention, without a trade, don't count.
+[[nodiscard]] std::uint32_t levels_touched(const std::vector<Trade>& trades);
+
+// Point-in-time copy of every resting order in priority order — bids best
+// price first, then asks best price first, FIFO within a level — plus the
+// sequence counter, which is all that is needed to rebuild an identical book.
+// The trade hash is carried along so a restored book keeps its chain.
+// `positions` is for the pre-trade risk engine (risk.hpp), which stores the
+// accounts' net fills next to the orders: capture() leaves it empty and
+// restore() ignores it.
+struct AccountPosition {
+    AccountId    account;
+    std::int64_t qty;  // net filled qty, bought minus sold
+};
+
+struct BookImage {
+    std::uint64_t                next_seq    = 1;
+    std::uint64_t                lsn         = 0;  // journal position the image reflects (0 = none)
+    std::uint64_t                trade_hash  = 0;  // BookHash::trades / trade_count at capture
+    std::uint64_t                trade_count = 0;
+    std::uint64_t                event_seq   = 0;  // last OrderEvent sequence number at capture
+    std::vector<Order>           orders;
+    std::vector<AccountPosition> positions;
+};
+
+// Determinism fingerprints, maintained incrementally by every mutation.
+//   state  — order-independent sum of a per-order hash (id, side, price,
+//            remaining qty, seq) over all resting orders, so two books with
+//            the same resting orders and priority hash equal however they
+//            got there.
+//   trades — hash chained over every trade in emission order since the book
+//            was constructed (restore() continues the image's chain).
+struct BookHash {
+    std::uint64_t state       = 0;
+    std::uint64_t trades      = 0;
+    std::uint64_t trade_count = 0;
+};
+
+// Activity counters and current shape of one book (see OrderBook::stats()).
+struct BookStats {
+    std::uint64_t added       = 0;  // orders accepted (limit and market)
+    std::uint64_t cancelled   = 0;  // successful cancels
+    std::uint64_t filled      = 0;  // resting orders completely filled
+    std::uint64_t trades      = 0;
+    std::uint64_t rejected    = 0;  // add_limit / add_market calls refused
+    std::uint64_t levels      = 0;  // price levels now, both sides
+    std::uint64_t resting     = 0;  // resting orders now
+    std::uint64_t peak_levels = 0;  // most levels seen at once
+    std::uint64_t prevented   = 0;  // self-trades prevented (StpMode applied)
+};
+
+// Aggregate state of one price level.
+struct DepthLevel {
+    std::int64_t  price;
+    std::int64_t  qty;    // total resting quantity
+    std::uint32_t count;  // resting orders
+};
+
+struct BookDepth {
+    std::vector<DepthLevel> bids;  // best first
+    std::vector<DepthLevel> asks;  // best first
+};
+
+// Best price per side; nullopt = side empty.
+struct Touch {
+    std::optional<std::int64_t> bid;
+    std::optional<std::int64_t> ask;
+};
+
+// New state of a price level after a command; qty == 0 and count == 0 mean
+// the level is gone.
+struct LevelUpdate {
+    Side       side;
+    DepthLevel level;
+};
+
+enum class OrderEventType : std::uint8_t {
+    Add     = 1,  // order rests:              qty = remaining = resting qty
+    Execute = 2,  // resting order filled:     qty = fill, remaining after, contra = aggressor
+    Cancel  = 3,  // order removed by cancel:  qty = removed qty, remaining = 0
+                  // (also self-trade prevention removing a resting order)
+    Reduce  = 4,  // self-trade decrement:     qty = removed qty, remaining after (> 0)
+};
+
+// One order-by-order (L3) event. `event_seq` is dense per book and counts
+// every event whether or not a listener is installed, so a consumer detects
+// gaps and resyncs from capture(), whose BookImage::event_seq is the last
+// event the image includes.
+struct OrderEvent {
+    std::uint64_t  event_seq;
+    OrderEventType type;
+    Side           side;
+    AccountId      owner;         // of order `id`
+    OrderId        id;
+    std::int64_t   price;
+    std::int64_t   qty;
+    std::int64_t   remaining;
+    std::uint64_t  order_seq;     // the order's time-priority seq
+    OrderId        contra;        // Execute only
+    AccountId      contra_owner;  // Execute only
+};
+
+// Market-data sink (also RiskEngine's feed, risk.hpp). Called synchronously
+// under the book's exclusive lock, so implementations must be quick and must
+// not call back into the book. Events are passed by reference to stack
+// objects; nothing is allocated for them.
+//   on_level — each level a command touched, once, with its final state (L2)
+//   on_order — every order event, in sequence (L3)
+class BookListener {
+public:
+    virtual ~BookListener() = default;
+    virtual void on_level(const LevelUpdate&) {}
+    virtual void on_order(const OrderEvent&) {}
+};
+
 class OrderBook {
 public:
     OrderBook();
 
     // Returns trades generated. [[nodiscard]]: caller must not silently drop fills.
+    // An order with an `owner` never trades against a resting order of the
+    // same owner; `stp` says what happens instead (StpMode). Any qty the
+    // prevention removes from the incoming order is dropped, not rested.
     [[nodiscard]] std::vector<Trade> add_limit(OrderId id, Side side,
-                                               std::int64_t price, std::int64_t qty);
+                                               std::int64_t price, std::int64_t qty,
+                                               AccountId owner = 0, StpMode stp = StpMode::CancelNewest);
     [[nodiscard]] std::vector<Trade> add_market(OrderId id, Side side,
-                                                std::int64_t qty);
+                                                std::int64_t qty,
+                                                AccountId owner = 0, StpMode stp = StpMode::CancelNewest);
 
     // Returns true if order was found and removed.
     [[nodiscard]] bool cancel(OrderId id);
@@ -45,11 +184,37 @@ public:
     // Read-only queries — safe to call concurrently.
     [[nodiscard]] std::optional<std::int64_t> best_bid() const;
     [[nodiscard]] std::optional<std::int64_t> best_ask() const;
+    [[nodiscard]] Touch touch() const;  // both, under one lock
     [[nodiscard]] bool empty() const;
+    [[nodiscard]] BookHash hash() const;  // O(1)
+
+    // Lock-free: the counters are written by the lock holder only, once per
+    // command and never inside the matching loop, and read here without the
+    // lock, so a monitoring thread never stalls the writer. Fields are read
+    // one by one and may be a command apart from each other.
+    [[nodiscard]] BookStats stats() const;
+
+    // Top `levels` levels per side from the maintained aggregates (no walk
+    // over orders). The default is full depth, the L2 snapshot subscribers
+    // start from before applying LevelUpdates.
+    [[nodiscard]] BookDepth depth(std::size_t levels = SIZE_MAX) const;
+
+    // Installs (or with nullptr removes) the level-update sink. restore()
+    // doesn't report updates; take a fresh depth() after it.
+    void set_listener(BookListener* listener);
+
+    // Snapshot / restore. capture() holds the shared lock only for the copy;
+    // serialising the image can then happen off the matching thread.
+    [[nodiscard]] BookImage capture() const;
+    void restore(const BookImage& image);      // replaces the whole book
+    void snapshot(std::ostream& out) const;    // capture() + write_snapshot() (snapshot.hpp)
+    void restore(std::istream& in);            // read_snapshot() + restore()
 
 private:
     struct Level {
         std::list<Order> q;  // FIFO; std::list gives stable iterators
+        std::int64_t     total_qty = 0;
+        std::uint32_t    count     = 0;
     };
 
     // bids: highest price first
@@ -71,7 +236,33 @@ private:
     // shared_mutex: concurrent readers (best_bid/ask), exclusive writers (add/cancel).
     mutable std::shared_mutex mtx_;
 
+    BookHash      hash_;                // guarded by mtx_
+    BookListener* listener_  = nullptr; // guarded by mtx_
+    std::uint64_t event_seq_ = 0;       // guarded by mtx_
+
+    // Per-command tallies of match_incoming's self-trade prevention.
+    std::uint64_t stp_prevented_ = 0;   // preventions applied
+    std::uint64_t stp_removed_   = 0;   // resting orders they removed
+
+    // BookStats as single-writer atomics: written under mtx_, read without it.
+    struct Counters {
+        std::atomic<std::uint64_t> added{0}, cancelled{0}, filled{0}, trades{0}, rejected{0};
+        std::atomic<std::uint64_t> levels{0}, resting{0}, peak_levels{0}, prevented{0};
+    } counters_;
+
+    // Ends the call's trace span as rejected, counts, then throws std::invalid_argument.
+    [[noreturn]] void reject(const char* why, TraceOp op, OrderId id);
+    void note_shape();  // refreshes levels / resting / peak_levels
+
+    void add_trade_hash(const Trade& t);
+    void report_level(Side side, std::int64_t price, const Level* lvl);  // lvl == nullptr: level removed
+    void report_order(OrderEventType type, const Order& o, std::int64_t qty,
+                      OrderId contra = 0, AccountId contra_owner = 0);
+
     // Internals (called under exclusive lock only).
-    std::vector<Trade> match_incoming(Order& incoming);
+    std::vector<Trade> match_incoming(Order& incoming, StpMode stp);
+    // Applies `stp` to `incoming` and the same-owner resting order `it` of
+    // `lvl` instead of a fill; may erase `it`.
+    void prevent_self_trade(Order& incoming, Level& lvl, std::list<Order>::iterator it, StpMode stp);
     void maybe_erase_empty_level(Side side, std::int64_t price);
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ── Hardware performance counters ─────────────────────────────────────────────
+//
+// Counts cycles, instructions, L1D and last-level cache read misses, branch
+// misses and dTLB read misses for the calling thread through Linux
+// perf_event_open. Only user-space events are counted, so the default
+// perf_event_paranoid setting (2) is enough and no external tooling is
+// needed. The events form one group that the kernel starts and stops
+// together, so ratios between them (IPC, misses per instruction) are
+// consistent.
+//
+// Events the CPU or hypervisor does not expose are reported as unavailable
+// rather than failing the run. On other platforms every event is
+// unavailable.
+
+class PerfCounters {
+public:
+    enum Event : std::size_t { Cycles, Instructions, L1dMisses, LlcMisses, BranchMisses, DtlbMisses, kEvents };
+    using Counts = std::array<std::uint64_t, kEvents>;
+
+    PerfCounters();  // opened stopped and zeroed
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&)            = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    [[nodiscard]] bool available() const noexcept { return leader_ >= 0; }
+    [[nodiscard]] bool available(Event e) const noexcept { return fds_[e] >= 0; }
+    // Why the first unavailable event could not be opened ("" if none failed).
+    [[nodiscard]] const std::string& error() const noexcept { return error_; }
+
+    // Counting accumulates across start()/stop() pairs until reset().
+    void start() noexcept;
+    void stop() noexcept;
+    void reset() noexcept;
+
+    // Counts since the last reset, scaled up if the kernel had to time-share
+    // the counters with other groups; 0 for unavailable events.
+    [[nodiscard]] Counts read() const noexcept;
+
+    // "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses".
+    static const char* name(Event e) noexcept;
+
+private:
+    int                       leader_ = -1;
+    std::array<int, kEvents>  fds_;
+    std::array<Event, kEvents> order_;  // events in the group's read order
+    std::size_t               opened_ = 0;
+    std::string               error_;
+};
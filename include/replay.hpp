@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ── Deterministic replay ──────────────────────────────────────────────────────
+//
+// Replays command files into fresh books and reduces each run to digests that
+// can be compared against production or a previous build. A file is either a
+// binary journal (journal.hpp) or text commands, one per line, in the format
+// of parse_command() (command.hpp). Each file is an independent book, so a
+// directory of per-symbol files replays in parallel.
+
+struct ReplayResult {
+    std::string   path;
+    std::uint64_t commands     = 0;
+    std::uint64_t trades       = 0;
+    std::uint64_t trade_digest = 0;  // BookHash::trades after the last command
+    std::uint64_t book_digest  = 0;  // BookHash::state after the last command
+    std::string   error;             // set if the file couldn't be replayed; digests are then partial
+};
+
+// Replays one file. Never throws; failures are reported in `error`
+// (text errors carry the line number).
+ReplayResult replay_file(const std::string& path);
+
+// Replays every regular file of `dir` (or just `dir` if it is a file) on
+// `threads` worker threads (0 = hardware concurrency). Results are sorted by
+// path, so the output doesn't depend on scheduling.
+std::vector<ReplayResult> replay_paths(const std::string& dir, unsigned threads = 0);
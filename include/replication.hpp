@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "journal.hpp"
+
+class RiskEngine;
+
+// ── Hot-standby replication ───────────────────────────────────────────────────
+//
+// A primary engine streams every accepted command to follower engines over a
+// unix stream socket; a follower applies them to its own OrderBook and takes
+// over when the primary goes away. Wire format, per follower connection:
+//
+//   u64 length, then a snapshot (snapshot.hpp) of the primary's book at the
+//   moment the follower was accepted, with lsn = last record already sent
+//   (and, with a risk engine, its positions)
+//   JournalRecord (journal.hpp) stream, lsn = snapshot lsn + 1, + 2, ...
+//
+// Records are sent after the journal commit and, at the latest, at batch
+// ends, before the replies of the batch are released: both the interactive
+// and the shm loop hold a batch's replies in an outbox until
+// EngineSinks::end_batch() has shipped it, so every command a client saw
+// acknowledged has reached the follower's socket, however large the burst.
+// A long burst is streamed in the middle of the batch (send_due()), and
+// EngineSinks commits the journal before each such send, so a follower
+// never holds a command the primary's journal could lose. Sends block: a
+// follower that falls behind by more than the socket buffer slows the
+// primary down rather than silently missing commands.
+
+class ReplicationPrimary {
+public:
+    // Listens on `socket_path` (replacing a stale socket file). Records are
+    // numbered from `last_lsn` + 1, so they line up with the journal's lsns.
+    ReplicationPrimary(const std::string& socket_path, std::uint64_t last_lsn);
+    ~ReplicationPrimary();
+    ReplicationPrimary(const ReplicationPrimary&) = delete;
+    ReplicationPrimary& operator=(const ReplicationPrimary&) = delete;
+
+    // Buffers one accepted command (already applied to the book).
+    void append(const Command& cmd);
+
+    // Whether kSendBatch records are pending: a long burst should then be
+    // sent early instead of piling up until the batch ends.
+    [[nodiscard]] bool send_due() const { return pending_.size() >= kSendBatch; }
+
+    // Sends the buffered records to every follower; the caller commits them
+    // to its journal first. Followers whose connection fails are dropped.
+    void send();
+
+    // send()s the buffered records, then accepts followers that connected
+    // since the last call and sends each a snapshot of `ob` (carrying
+    // `risk`'s positions, if given).
+    void flush(const OrderBook& ob, const RiskEngine* risk = nullptr);
+
+    [[nodiscard]] std::size_t   followers() const { return followers_.size(); }
+    [[nodiscard]] std::uint64_t last_lsn() const { return next_lsn_ - 1; }
+
+private:
+    static constexpr std::size_t kSendBatch = 1024;
+
+    std::string                path_;
+    int                        listen_fd_;
+    std::uint64_t              next_lsn_;
+    std::vector<int>           followers_;
+    std::vector<JournalRecord> pending_;
+};
+
+class ReplicationFollower {
+public:
+    explicit ReplicationFollower(const std::string& socket_path);  // connects; throws if no primary
+    ~ReplicationFollower();
+    ReplicationFollower(const ReplicationFollower&) = delete;
+    ReplicationFollower& operator=(const ReplicationFollower&) = delete;
+
+    // Waits up to `timeout_ms` for data and applies whatever arrived to `ob`
+    // (the initial snapshot replaces its contents and seeds `risk`, if given,
+    // which should be `ob`'s listener to follow the records). Returns false
+    // once the primary has closed the stream. Throws std::runtime_error on a
+    // corrupt or out-of-sequence record.
+    bool poll(OrderBook& ob, int timeout_ms, RiskEngine* risk = nullptr);
+
+    [[nodiscard]] bool          synced() const { return synced_; }  // snapshot received
+    [[nodiscard]] std::uint64_t last_lsn() const { return last_lsn_; }
+
+private:
+    void consume(OrderBook& ob, RiskEngine* risk);
+
+    int               fd_;
+    std::vector<char> buf_;
+    std::size_t       used_     = 0;
+    bool              synced_   = false;
+    std::uint64_t     last_lsn_ = 0;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "order_book.hpp"
+
+// ── Pre-trade risk ────────────────────────────────────────────────────────────
+//
+// Per-account limits checked before an order reaches the book:
+//   max_qty       order quantity
+//   max_notional  price * qty (market orders: at the touch they would take)
+//   max_open      resting orders
+//   band          ticks between a limit price and the touch (the opposite
+//                 best price, or the same side's when that is empty)
+//   max_position  net position if the order and every open order of the
+//                 account on the same side filled
+// 0 means no limit. Accounts are the orders' owners (order_book.hpp); the
+// anonymous account 0 is checked like any other.
+//
+// Everything check() reads for an account sits in one cache line of a flat
+// array indexed by account id, so a check is a handful of compares with no
+// lookup and no lock. The state is kept current by installing the engine as
+// the book's listener: fills move positions, and adds, fills, cancels and
+// self-trade reductions move open orders and open quantity, one O(1) update
+// per event. A listener installed behind it (forward_to) still gets every
+// event.
+//
+// Positions outlive the process through the book's images: save() adds them
+// to a snapshot, seed() takes them back with the open orders, and the fills
+// replayed after the image (the journal tail, or the replication stream of a
+// follower) move them as they did live.
+
+struct RiskLimits {
+    std::int64_t  max_qty      = 0;
+    std::int64_t  max_notional = 0;
+    std::uint32_t max_open     = 0;
+    std::int64_t  band         = 0;
+    std::int64_t  max_position = 0;
+};
+
+struct AccountRisk {
+    std::int64_t  position      = 0;  // net filled qty, bought minus sold
+    std::int64_t  open_buy_qty  = 0;  // resting qty per side
+    std::int64_t  open_sell_qty = 0;
+    std::uint32_t open_orders   = 0;
+    std::uint64_t rejects       = 0;
+};
+
+enum class RiskReject : std::uint8_t { None = 0, Qty, Notional, OpenOrders, PriceBand, Position, Account };
+
+const char* risk_reject_name(RiskReject r);  // "max_qty", "max_notional", ...
+
+// Parses "key=value" words (the RiskLimits field names) over `base`; throws
+// std::invalid_argument on anything else.
+RiskLimits parse_risk_limits(std::string_view words, RiskLimits base = {});
+
+class RiskEngine final : public BookListener {
+public:
+    static constexpr AccountId kDefaultMaxAccount = 65'535;
+
+    explicit RiskEngine(AccountId max_account = kDefaultMaxAccount);
+
+    // Reads a config file: "default key=value ..." sets the limits of every
+    // account without a line of its own, "<account> key=value ..." one
+    // account's; '#' starts a comment. Throws std::invalid_argument /
+    // std::runtime_error.
+    void load(const std::string& path);
+
+    void set_default_limits(const RiskLimits& limits);         // accounts without set_limits
+    void set_limits(AccountId account, const RiskLimits& limits);  // throws std::invalid_argument
+    [[nodiscard]] RiskLimits  limits(AccountId account) const;
+    [[nodiscard]] AccountRisk account(AccountId account) const;
+    [[nodiscard]] AccountId   max_account() const noexcept { return static_cast<AccountId>(slots_.size() - 1); }
+
+    // Whether `account` may send this order, given the book's touch;
+    // `price` 0 = market order. Counts a rejection against the account.
+    [[nodiscard]] RiskReject check(AccountId account, Side side, std::int64_t price, std::int64_t qty,
+                                   std::optional<std::int64_t> bid, std::optional<std::int64_t> ask) noexcept {
+        if (account >= slots_.size()) return RiskReject::Account;
+        const Slot& s = slots_[account];
+        const RiskReject r = evaluate(s, side, price, qty, side == Side::Buy ? ask : bid, side == Side::Buy ? bid : ask);
+        if (r != RiskReject::None) ++rejects_[account];
+        return r;
+    }
+
+    // Resets every account to the image: open orders and open qty from its
+    // resting orders, positions from image.positions (flat if absent).
+    void seed(const BookImage& image);
+    // Stores the non-zero positions in image.positions, by account.
+    void save(BookImage& image) const;
+
+    void forward_to(BookListener* next) noexcept { next_ = next; }
+    void on_level(const LevelUpdate& u) override { if (next_) next_->on_level(u); }
+    void on_order(const OrderEvent& e) override;
+
+private:
+    static constexpr std::int64_t kNoLimit = std::numeric_limits<std::int64_t>::max();
+
+    // One cache line: the limits (0 already turned into kNoLimit) and the
+    // state check() reads.
+    struct alignas(64) Slot {
+        std::int64_t  max_qty      = kNoLimit;
+        std::int64_t  max_notional = kNoLimit;
+        std::int64_t  band         = kNoLimit;
+        std::int64_t  max_position = kNoLimit;
+        std::int64_t  position     = 0;
+        std::int64_t  open_buy     = 0;
+        std::int64_t  open_sell    = 0;
+        std::uint32_t max_open     = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t open_orders  = 0;
+    };
+    static_assert(sizeof(Slot) == 64);
+
+    // `far`: the best price on the other side (what the order would take);
+    // `near`: the best price on its own side.
+    static RiskReject evaluate(const Slot& s, Side side, std::int64_t price, std::int64_t qty,
+                               std::optional<std::int64_t> far, std::optional<std::int64_t> near) noexcept {
+        if (qty > s.max_qty) return RiskReject::Qty;
+        const bool market = price == 0;
+        if (s.max_notional != kNoLimit && (!market || far)) {
+            std::int64_t notional;
+            if (__builtin_mul_overflow(market ? *far : price, qty, &notional) || notional > s.max_notional)
+                return RiskReject::Notional;
+        }
+        if (!market && s.open_orders >= s.max_open) return RiskReject::OpenOrders;
+        // Quantities and prices are unvalidated client input here: every sum
+        // is overflow-checked, and an overflow is a breach.
+        if (!market && s.band != kNoLimit) {
+            const std::optional<std::int64_t> ref = far ? far : near;
+            std::int64_t off;
+            if (ref && (__builtin_sub_overflow(price, *ref, &off) || off > s.band || off < -s.band))
+                return RiskReject::PriceBand;
+        }
+        if (s.max_position != kNoLimit) {
+            std::int64_t worst;
+            const bool overflow = side == Side::Buy
+                ? __builtin_add_overflow(s.position, s.open_buy, &worst) || __builtin_add_overflow(worst, qty, &worst)
+                : __builtin_add_overflow(s.open_sell, qty, &worst) || __builtin_sub_overflow(worst, s.position, &worst);
+            if (overflow || worst > s.max_position) return RiskReject::Position;
+        }
+        return RiskReject::None;
+    }
+
+    static Slot to_slot(const RiskLimits& l, const Slot& state);
+
+    std::vector<Slot>          slots_;    // indexed by account
+    std::vector<std::uint64_t> rejects_;  // cold: only written on a rejection
+    std::vector<bool>          custom_;   // has limits of its own
+    BookListener*              next_ = nullptr;
+};
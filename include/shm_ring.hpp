@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "command.hpp"
+
+// ── Shared-memory transport ───────────────────────────────────────────────────
+//
+// One file (normally /dev/shm/<name>) holding two single-producer /
+// single-consumer rings: commands (client → engine) and events
+// (engine → client). All integers are little-endian.
+//
+//   offset  size  field
+//   0       8     magic            "LOBSHM01"
+//   8       4     version          1
+//   12      4     cmd_capacity     records, power of two
+//   16      4     evt_capacity     records, power of two
+//   20      4     cmd_record_size  40 (ShmCommand)
+//   24      4     evt_record_size  48 (ShmEvent)
+//   28      4     engine_state     0 = not attached, 1 = attached, 2 = exited
+//   32      4     client_state     1 = open, 2 = closed (engine exits once drained)
+//   64      8     cmd_head         next command to consume   (written by engine)
+//   128     8     cmd_tail         next command slot to fill (written by client)
+//   192     8     evt_head         next event to consume     (written by client)
+//   256     8     evt_tail         next event slot to fill   (written by engine)
+//   512     ...   command ring     cmd_capacity * 40 bytes
+//   ...     ...   event ring       evt_capacity * 48 bytes, starts 64-byte aligned
+//
+// head/tail are free-running counters; the slot is counter % capacity. A
+// producer writes the record first and then publishes it by storing the new
+// tail (release); a consumer loads the tail (acquire) before reading records.
+// Every command produces zero or more Trade / Book / Cancel / Level events followed by
+// exactly one Ok or Error event, all carrying the command's tag.
+
+struct ShmCommand {
+    std::uint64_t tag;
+    Command       cmd;
+};
+
+enum class ShmEventType : std::uint8_t { Trade = 1, Book = 2, Cancel = 3, Ok = 4, Error = 5, Level = 6 };
+
+// Field use per type:
+//   Trade  a=price b=qty c=buy_id d=sell_id
+//   Book   a=best_bid b=best_ask  flags bit0 = bid present, bit1 = ask present
+//   Cancel c=order id             flags bit0 = found
+//   Level  a=price b=total qty c=orders  flags bit0 = ask side (Depth replies,
+//          bids best-first, then asks best-first)
+//   Error  a..d = NUL-padded message (at most 32 bytes)
+struct ShmEvent {
+    std::uint64_t tag;
+    ShmEventType  type;
+    std::uint8_t  flags;
+    std::uint8_t  pad[6];
+    std::int64_t  a;
+    std::int64_t  b;
+    std::uint64_t c;
+    std::uint64_t d;
+};
+
+static_assert(sizeof(ShmCommand) == 40, "ShmCommand layout is shared with api/shm_client.py");
+static_assert(sizeof(ShmEvent)   == 48, "ShmEvent layout is shared with api/shm_client.py");
+
+class ShmChannel {
+public:
+    static constexpr std::uint64_t kMagic   = 0x31304d4853424f4cULL;  // "LOBSHM01"
+    static constexpr std::uint32_t kVersion = 1;
+
+    // Creates (or truncates) the file at `path` and initialises an empty channel.
+    static ShmChannel create(const std::string& path,
+                             std::uint32_t cmd_capacity, std::uint32_t evt_capacity);
+    // Maps an existing channel created by a client. Throws on bad magic/version.
+    static ShmChannel attach(const std::string& path);
+
+    ShmChannel(ShmChannel&& other) noexcept;
+    ShmChannel& operator=(ShmChannel&&) = delete;
+    ShmChannel(const ShmChannel&) = delete;
+    ~ShmChannel();
+
+    // Engine side.
+    [[nodiscard]] bool pop_command(ShmCommand& out);
+    [[nodiscard]] bool push_event(const ShmEvent& ev);  // false if the event ring is full
+
+    // Client side.
+    [[nodiscard]] bool push_command(const ShmCommand& c);  // false if the command ring is full
+    [[nodiscard]] bool pop_event(ShmEvent& out);
+
+    void set_engine_state(std::uint32_t s);
+    void set_client_state(std::uint32_t s);
+    [[nodiscard]] std::uint32_t engine_state() const;
+    [[nodiscard]] std::uint32_t client_state() const;
+
+private:
+    ShmChannel(std::byte* base, std::size_t size);
+
+    std::byte*  base_;
+    std::size_t size_;
+};
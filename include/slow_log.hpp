@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "command.hpp"
+#include "latency.hpp"
+
+// ── Slow-op log ───────────────────────────────────────────────────────────────
+//
+// A flight recorder for latency spikes: every book call that takes longer
+// than a threshold is kept together with the command, the price levels it
+// filled against, the fills it generated and the top of the book right after
+// it.
+// The newest `capacity` entries are kept. Below the threshold, offer() is one
+// comparison; the book is only inspected for the (rare) slow ops, so the log
+// can stay on in production. Owned by the command loop, its only user.
+
+inline constexpr std::size_t kSlowLogDepth = 3;  // levels per side in a snapshot
+
+struct SlowOp {
+    std::uint64_t seq;         // slow ops recorded before this one
+    std::int64_t  unix_us;     // wall clock when recorded
+    std::uint64_t ns;          // time in the book call
+    Command       cmd;
+    std::uint32_t levels;      // price levels filled against (levels_touched: not
+                               // those only walked through self-trade prevention)
+    std::uint32_t fills;       // trades generated
+    BookDepth     top;         // best kSlowLogDepth levels per side, after the call
+};
+
+class SlowLog {
+public:
+    // capacity 0 disables the log.
+    explicit SlowLog(std::uint64_t threshold_ns, std::size_t capacity = 128);
+
+    // Records the call when `ticks` (CycleClock) exceeds the threshold;
+    // returns whether it did. `ob` is read for the snapshot only then.
+    bool offer(const Command& cmd, std::uint64_t ticks, const std::vector<Trade>& trades, const OrderBook& ob) {
+        if (ticks <= threshold_ticks_ || capacity_ == 0) return false;
+        record(cmd, ticks, trades, ob);
+        return true;
+    }
+
+    [[nodiscard]] std::vector<SlowOp> entries(std::size_t max = SIZE_MAX) const;  // newest first
+    [[nodiscard]] std::uint64_t total() const noexcept { return total_; }  // ever recorded
+    [[nodiscard]] std::uint64_t threshold_ns() const noexcept { return threshold_ns_; }
+    void clear() noexcept { ring_.clear(); next_ = 0; }
+
+private:
+    void record(const Command& cmd, std::uint64_t ticks, const std::vector<Trade>& trades, const OrderBook& ob);
+
+    std::uint64_t       threshold_ns_;
+    std::uint64_t       threshold_ticks_;
+    std::size_t         capacity_;
+    std::vector<SlowOp> ring_;       // grows to capacity_, then wraps
+    std::size_t         next_  = 0;  // slot of the next entry once full
+    std::uint64_t       total_ = 0;
+};
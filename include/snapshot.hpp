@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+#include "order_book.hpp"
+
+// ── Book snapshots ────────────────────────────────────────────────────────────
+//
+// Compact binary form of a BookImage. Restoring a snapshot and replaying the
+// journal records after `lsn` rebuilds the book without replaying the whole
+// journal. Layout (little-endian):
+//
+//   magic "LOBSNAP1" | u32 version = 5 | u32 record size = 40
+//   u64 lsn | u64 next_seq | u64 trade hash | u64 trade count | u64 event seq
+//   u64 order count
+//   order records, priority order: u64 id, i64 price, i64 qty, u64 seq, u8 side, 3 pad,
+//   u32 owner
+//   u64 position count
+//   position records, by account: u32 account, 4 pad, i64 qty
+//   u64 FNV-1a checksum of everything before it
+//
+// Readers throw std::runtime_error on a truncated or corrupt snapshot.
+
+void      write_snapshot(std::ostream& out, const BookImage& image);
+BookImage read_snapshot(std::istream& in);
+
+// Durable file variants: the image is written to "<path>.tmp", fsynced and
+// renamed over `path`, so a crash never leaves a half-written snapshot.
+void                     write_snapshot_file(const std::string& path, const BookImage& image);
+std::optional<BookImage> load_snapshot_file(const std::string& path);  // nullopt if missing
+
+// The tmp + fsync + rename sequence behind write_snapshot_file, for other
+// snapshot encodings: `fill` writes the complete contents.
+void write_file_durably(const std::string& path, const std::function<void(std::ostream&)>& fill);
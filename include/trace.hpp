@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "latency.hpp"
+
+// ── Hot-path tracing ──────────────────────────────────────────────────────────
+//
+// With -DLOB_TRACE=ON, OrderBook's add_limit, add_market, cancel and
+// match_incoming record a begin and an end TraceRecord each: a 32-byte,
+// TSC-stamped record of the operation, order id, price levels touched and
+// fills. A call rejected by validation still ends its span, with an end
+// record flagged kTraceRejected. Records go into a ring owned by the calling thread (the last
+// kTraceCapacity records per thread are kept), so tracing takes no lock and
+// allocates only on a thread's first record. Without LOB_TRACE the trace
+// points expand to nothing and their arguments are not evaluated.
+//
+// trace_dump() writes every thread's ring to a file; it only uses
+// async-signal-safe calls, so trace_dump_on_signal() can dump from a signal
+// handler while the engine is stuck. lob_trace_decode (tools/) turns a dump
+// into a timeline, folded stacks for flame graphs, or a Chrome trace.
+//
+// File layout (little-endian): TraceFileHeader, then per ring a
+// TraceRingHeader followed by its records, oldest first.
+
+enum class TraceOp : std::uint8_t { AddLimit = 1, AddMarket = 2, Cancel = 3, Match = 4 };
+enum class TracePhase : std::uint8_t { Begin = 0, End = 1 };
+
+struct TraceRecord {
+    std::uint64_t tsc;     // CycleClock ticks
+    std::uint64_t id;      // order id
+    std::uint32_t levels;  // price levels touched (End only)
+    std::uint32_t fills;   // trades generated (End only); Cancel: levels = fills = 1 if found
+    std::uint32_t tid;     // ring number, 0 = first thread that traced
+    TraceOp       op;
+    TracePhase    phase;
+    std::uint8_t  flags;   // End only: kTraceRejected
+    std::uint8_t  pad;
+};
+static_assert(sizeof(TraceRecord) == 32);
+
+inline constexpr std::uint8_t kTraceRejected = 1;  // the call threw std::invalid_argument
+
+struct TraceFileHeader {
+    char          magic[8];  // "LOBTRC01"
+    std::uint32_t version;
+    std::uint32_t record_size;
+    double        ns_per_tick;
+    std::uint32_t rings;
+    std::uint32_t pad;
+};
+static_assert(sizeof(TraceFileHeader) == 32);
+
+struct TraceRingHeader {
+    std::uint32_t tid;
+    std::uint32_t records;  // records that follow
+    std::uint64_t dropped;  // older records overwritten
+};
+static_assert(sizeof(TraceRingHeader) == 16);
+
+inline constexpr std::size_t kTraceCapacity   = 1u << 16;  // records per thread (2 MiB)
+inline constexpr std::size_t kTraceMaxThreads = 64;
+
+namespace lob_trace {
+
+struct Ring {
+    std::atomic<std::uint64_t> head{0};  // records ever written; only the owner writes
+    std::uint32_t              tid = 0;
+    TraceRecord                slots[kTraceCapacity];
+};
+
+Ring* register_thread() noexcept;  // nullptr once kTraceMaxThreads rings exist
+
+inline void emit(TraceOp op, TracePhase phase, std::uint64_t id,
+                 std::uint32_t levels = 0, std::uint32_t fills = 0, std::uint8_t flags = 0) noexcept {
+    thread_local Ring* ring = register_thread();
+    if (!ring) return;
+    const std::uint64_t h = ring->head.load(std::memory_order_relaxed);
+    ring->slots[h & (kTraceCapacity - 1)] = TraceRecord{ CycleClock::now(), id, levels, fills, ring->tid, op, phase, flags, 0 };
+    ring->head.store(h + 1, std::memory_order_release);
+}
+
+}  // namespace lob_trace
+
+// Whether the order book was built with trace points.
+constexpr bool trace_enabled() noexcept {
+#if defined(LOB_TRACE) && LOB_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Writes all rings to `path`; returns the number of records written, or -1
+// on error (errno set). Async-signal-safe. Records being written while the
+// dump runs may come out torn; dump from a quiet engine when it matters.
+long trace_dump(const char* path) noexcept;
+
+// Dumps to `path` whenever `signo` arrives (e.g. SIGUSR2). Also calibrates
+// the clock, so dumps carry ticks-to-ns; without it the decoder calibrates
+// on the machine it runs on.
+void trace_dump_on_signal(int signo, const std::string& path);
+
+// Reads a dump back: every record of every ring, ordered by tsc.
+struct TraceFile {
+    double                   ns_per_tick = 1.0;
+    std::uint64_t            dropped     = 0;
+    std::vector<TraceRecord> records;
+};
+TraceFile read_trace(const std::string& path);  // throws std::runtime_error
+
+#if defined(LOB_TRACE) && LOB_TRACE
+#define LOB_TRACE_BEGIN(op, id)              ::lob_trace::emit((op), TracePhase::Begin, (id))
+#define LOB_TRACE_END(op, id, levels, fills) ::lob_trace::emit((op), TracePhase::End, (id), (levels), (fills))
+#define LOB_TRACE_REJECT(op, id)             ::lob_trace::emit((op), TracePhase::End, (id), 0, 0, kTraceRejected)
+#else
+#define LOB_TRACE_BEGIN(op, id)              ((void)0)
+#define LOB_TRACE_END(op, id, levels, fills) ((void)0)
+#define LOB_TRACE_REJECT(op, id)             ((void)0)
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "command.hpp"
+
+// ── Synthetic order flow ──────────────────────────────────────────────────────
+//
+// Generates command streams shaped like real books rather than uniform noise:
+// a mid price that random-walks, limit prices placed relative to the touch
+// with power-law distance (most orders near the touch, a long tail of deep
+// ones), power-law order sizes, cancels that prefer recent orders, and bursty
+// arrival times. The generator does not look at the book, so a stream is a
+// pure function of its config and seed and can be generated ahead of a timed
+// run. Cancels may name orders that have already filled; they are misses, as
+// in real flow.
+//
+// Config files are "key = value" lines ('#' starts a comment). A
+// "preset = <name>" line loads that preset first; later lines override it.
+
+struct WorkloadConfig {
+    std::uint64_t seed = 42;
+
+    // Operation mix (relative weights).
+    double add_weight    = 0.70;
+    double cancel_weight = 0.20;
+    double market_weight = 0.10;
+
+    // Prices, in ticks of `tick`. The touch is mid -/+ half_spread.
+    std::int64_t start_mid     = 10'000;
+    std::int64_t tick          = 1;
+    std::int64_t half_spread   = 1;
+    double       mid_step_prob = 0.0;   // chance per command that mid moves one tick up or down
+
+    // Passive limit orders rest `d` ticks behind their own touch,
+    // P(d) ~ (d + 1)^-depth_alpha for 0 <= d < max_depth (alpha 0 = uniform).
+    double       depth_alpha = 0.0;
+    std::int64_t max_depth   = 10;
+
+    // This fraction of limit orders is priced up to cross_depth ticks through
+    // the opposite touch instead.
+    double       cross_prob  = 0.0;
+    std::int64_t cross_depth = 1;
+
+    // Sizes in lots, P(s) ~ s^-size_alpha for min <= s <= max.
+    std::int64_t lot             = 1;
+    std::int64_t size_min        = 1;
+    std::int64_t size_max        = 10;
+    std::int64_t market_size_min = 1;
+    std::int64_t market_size_max = 5;
+    double       size_alpha      = 0.0;
+
+    // Age of a cancelled order, counted in orders added since: exponential
+    // with this mean. 0 = uniform over live orders.
+    double cancel_age_mean = 0.0;
+
+    // Inter-arrival gaps (used by open-loop runs): exponential with mean
+    // gap_ns; a burst starts with probability burst_prob per command and
+    // lasts burst_len_mean commands on average, with gaps burst_factor
+    // times shorter.
+    double gap_ns         = 1000.0;
+    double burst_prob     = 0.0;
+    double burst_len_mean = 0.0;
+    double burst_factor   = 1.0;
+};
+
+// "uniform" (approximately uniform prices and sizes), "equity" or
+// "futures". Throws std::invalid_argument for any other name.
+WorkloadConfig workload_preset(std::string_view name);
+
+// Reads a config file (see above); throws std::invalid_argument on unknown
+// keys or bad values, std::runtime_error if the file can't be read.
+WorkloadConfig load_workload_config(const std::string& path);
+
+// A preset name or a config file path.
+WorkloadConfig resolve_workload(const std::string& preset_or_path);
+
+struct WorkloadOp {
+    Command       cmd;
+    std::uint64_t gap_ns;  // intended time since the previous command
+};
+
+class WorkloadGenerator {
+public:
+    explicit WorkloadGenerator(const WorkloadConfig& cfg);
+
+    WorkloadOp next();
+    std::vector<WorkloadOp> generate(std::size_t n);
+
+    [[nodiscard]] std::int64_t mid() const { return mid_; }
+
+private:
+    std::int64_t draw_power(std::int64_t lo, std::int64_t hi, double alpha);
+    Side         draw_side() { return coin_(rng_) < 0.5 ? Side::Buy : Side::Sell; }
+    bool         pick_cancel(OrderId& id);
+    std::uint64_t draw_gap();
+
+    WorkloadConfig   cfg_;
+    std::mt19937_64  rng_;
+    std::uniform_real_distribution<double> coin_{0.0, 1.0};
+    std::int64_t     mid_;
+    OrderId          next_id_ = 1;
+    std::uint64_t    burst_left_ = 0;
+
+    // Ids of orders added, oldest first; 0 marks a cancelled slot. Compacted
+    // once more than half the slots are dead.
+    std::vector<OrderId> live_;
+    std::size_t          dead_ = 0;
+};
@@ -58,34 +58,43 @@ export function useLOB(wsUrl = WS_URL) {
         setState(p => ({ ...p, connected: true }))
       }
 
+      // A frame is one event, or an array of events when the server is
+      // catching this client up.
       ws.onmessage = (e) => {
         try {
-          const msg = JSON.parse(e.data)
-          if (msg.event === 'trade') {
-            const t = { ...msg.payload, id: msg.payload.buy_id, ts: Date.now() }
-            setState(p => ({
-              ...p,
-              trades:     [t, ...p.trades].slice(0, 100),
-              tradeCount: p.tradeCount + 1,
-            }))
-          }
-          if (msg.event === 'book') {
-            const { best_bid, best_ask } = msg.payload
-            setState(p => ({
-              ...p,
-              bids: best_bid ? { ...p.bids, [best_bid]: (p.bids[best_bid] || 0) + 1 } : p.bids,
-              asks: best_ask ? { ...p.asks, [best_ask]: (p.asks[best_ask] || 0) + 1 } : p.asks,
-            }))
-          }
-          if (msg.event === 'commentary') {
-            setState(p => ({
-              ...p,
-              commentary: { ...msg.payload, ts: Date.now() },
-            }))
-          }
+          const frame = JSON.parse(e.data)
+          for (const msg of Array.isArray(frame) ? frame : [frame]) handle(msg)
         } catch (_) {}
       }
 
+      function handle(msg) {
+        if (msg.event === 'trade') {
+          const t = { ...msg.payload, id: msg.payload.buy_id, ts: Date.now() }
+          setState(p => ({
+            ...p,
+            trades:     [t, ...p.trades].slice(0, 100),
+            tradeCount: p.tradeCount + 1,
+          }))
+        }
+        // 'book' events (top of book only) are not used: the ladder, and the
+        // best bid / ask derived from it, come from 'depth' alone.
+        if (msg.event === 'depth') {
+          // Aggregated levels straight from the engine: replaces the ladder.
+          const toMap = levels => Object.fromEntries(levels.map(l => [l.price, l.qty]))
+          setState(p => ({
+            ...p,
+            bids: toMap(msg.payload.bids),
+            asks: toMap(msg.payload.asks),
+          }))
+        }
+        if (msg.event === 'commentary') {
+          setState(p => ({
+            ...p,
+            commentary: { ...msg.payload, ts: Date.now() },
+          }))
+        }
+      }
+
       ws.onerror  = () => {}
       ws.onclose  = () => {
         setState(p => ({ ...p, connected: false }))
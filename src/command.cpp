@@ -0,0 +1,117 @@
+#include "command.hpp"
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Splits off the next whitespace-delimited token of `rest`.
+std::string_view next_token(std::string_view& rest) {
+    std::size_t b = 0;
+    while (b < rest.size() && (rest[b] == ' ' || rest[b] == '\t' || rest[b] == '\r')) ++b;
+    std::size_t e = b;
+    while (e < rest.size() && rest[e] != ' ' && rest[e] != '\t' && rest[e] != '\r') ++e;
+    auto tok = rest.substr(b, e - b);
+    rest.remove_prefix(e);
+    return tok;
+}
+
+template <typename T>
+T parse_number(std::string_view& rest, const char* what) {
+    auto tok = next_token(rest);
+    T v{};
+    auto [p, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), v);
+    if (tok.empty() || ec != std::errc{} || p != tok.data() + tok.size())
+        throw std::invalid_argument(std::string("Invalid ") + what + ": '" + std::string(tok) + "'");
+    return v;
+}
+
+Side parse_side(std::string_view& rest) {
+    auto tok = next_token(rest);
+    if (tok == "BUY")  return Side::Buy;
+    if (tok == "SELL") return Side::Sell;
+    throw std::invalid_argument("Invalid side: " + std::string(tok));
+}
+
+}  // namespace
+
+std::vector<Trade> apply_command(OrderBook& ob, const Command& cmd) {
+    // Binary commands (shm ring, journal, replication) skip the text parser:
+    // their enum bytes are checked here before the book trusts them.
+    if (cmd.type == CommandType::Add || cmd.type == CommandType::Market) {
+        if (cmd.side != Side::Buy && cmd.side != Side::Sell)
+            throw std::invalid_argument("Invalid side: " + std::to_string(static_cast<unsigned>(cmd.side)));
+        if (cmd.stp > StpMode::Decrement)
+            throw std::invalid_argument("Invalid STP mode: " + std::to_string(static_cast<unsigned>(cmd.stp)));
+    }
+    switch (cmd.type) {
+    case CommandType::Add:    return ob.add_limit(cmd.id, cmd.side, cmd.price, cmd.qty, cmd.owner, cmd.stp);
+    case CommandType::Market: return ob.add_market(cmd.id, cmd.side, cmd.qty, cmd.owner, cmd.stp);
+    case CommandType::Cancel: (void)ob.cancel(cmd.id); return {};
+    case CommandType::Status:
+    case CommandType::Depth:  return {};
+    }
+    throw std::invalid_argument("Unknown command type");
+}
+
+void parse_order_options(std::string_view rest, Command& cmd) {
+    for (auto word = next_token(rest); !word.empty(); word = next_token(rest)) {
+        if (word == "OWNER") {
+            cmd.owner = parse_number<AccountId>(rest, "owner");
+        } else if (word == "STP") {
+            const auto mode = next_token(rest);
+            if      (mode == "CANCEL_NEWEST") cmd.stp = StpMode::CancelNewest;
+            else if (mode == "CANCEL_OLDEST") cmd.stp = StpMode::CancelOldest;
+            else if (mode == "CANCEL_BOTH")   cmd.stp = StpMode::CancelBoth;
+            else if (mode == "DECREMENT")     cmd.stp = StpMode::Decrement;
+            else throw std::invalid_argument("Invalid STP mode: '" + std::string(mode) + "'");
+        } else {
+            throw std::invalid_argument("Unexpected: '" + std::string(word) + "'");
+        }
+    }
+}
+
+const char* stp_name(StpMode mode) {
+    switch (mode) {
+    case StpMode::CancelNewest: return "CANCEL_NEWEST";
+    case StpMode::CancelOldest: return "CANCEL_OLDEST";
+    case StpMode::CancelBoth:   return "CANCEL_BOTH";
+    case StpMode::Decrement:    return "DECREMENT";
+    }
+    return "?";
+}
+
+std::optional<Command> parse_command(std::string_view line) {
+    std::string_view rest = line;
+    const auto word = next_token(rest);
+    if (word.empty() || word[0] == '#') return std::nullopt;
+
+    Command c{};
+    if (word == "ADD") {
+        c.type  = CommandType::Add;
+        c.id    = parse_number<OrderId>(rest, "id");
+        c.side  = parse_side(rest);
+        c.price = parse_number<std::int64_t>(rest, "price");
+        c.qty   = parse_number<std::int64_t>(rest, "qty");
+        parse_order_options(rest, c);
+    } else if (word == "MARKET") {
+        c.type = CommandType::Market;
+        c.id   = parse_number<OrderId>(rest, "id");
+        c.side = parse_side(rest);
+        c.qty  = parse_number<std::int64_t>(rest, "qty");
+        parse_order_options(rest, c);
+    } else if (word == "CANCEL") {
+        c.type = CommandType::Cancel;
+        c.id   = parse_number<OrderId>(rest, "id");
+    } else if (word == "STATUS") {
+        c.type = CommandType::Status;
+    } else if (word == "DEPTH") {
+        c.type = CommandType::Depth;
+        c.qty  = parse_number<std::int64_t>(rest, "levels");
+        if (c.qty <= 0) throw std::invalid_argument("DEPTH levels must be positive");
+    } else {
+        throw std::invalid_argument("Unknown command: " + std::string(word));
+    }
+    return c;
+}
@@ -0,0 +1,208 @@
+#include "journal.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ── File format ───────────────────────────────────────────────────────────────
+
+namespace {
+
+constexpr char          kMagic[8]   = { 'L', 'O', 'B', 'J', 'R', 'N', 'L', '1' };
+constexpr std::uint32_t kVersion    = 1;
+constexpr std::size_t   kHeaderSize = 16;
+
+struct Header {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+};
+static_assert(sizeof(Header) == kHeaderSize);
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+void write_all(int fd, const void* data, std::size_t len) {
+    const auto* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = ::write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw_errno("journal write");
+        }
+        p   += n;
+        len -= static_cast<std::size_t>(n);
+    }
+}
+
+// A file shorter than the header is what a crash during creation leaves
+// behind; treat it like a missing journal.
+bool journal_exists(const std::string& path) {
+    struct stat st{};
+    return ::stat(path.c_str(), &st) == 0 && static_cast<std::size_t>(st.st_size) >= kHeaderSize;
+}
+
+}  // namespace
+
+std::uint64_t journal_checksum(const JournalRecord& rec) {
+    std::uint64_t h = 14695981039346656037ULL;
+    const auto* p = reinterpret_cast<const unsigned char*>(&rec);
+    for (std::size_t i = 0; i < offsetof(JournalRecord, checksum); ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool is_journal_file(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char magic[sizeof kMagic];
+    const bool ok = std::fread(magic, sizeof magic, 1, f) == 1 && std::memcmp(magic, kMagic, sizeof kMagic) == 0;
+    std::fclose(f);
+    return ok;
+}
+
+// ── Reader ────────────────────────────────────────────────────────────────────
+
+JournalReader::JournalReader(const std::string& path)
+    : f_(std::fopen(path.c_str(), "rb")), valid_bytes_(kHeaderSize) {
+    if (!f_) throw_errno("open " + path);
+    Header h{};
+    if (std::fread(&h, sizeof h, 1, f_) != 1 ||
+        std::memcmp(h.magic, kMagic, sizeof kMagic) != 0 ||
+        h.version != kVersion || h.record_size != sizeof(JournalRecord)) {
+        std::fclose(f_);
+        throw std::runtime_error("not a journal (bad header): " + path);
+    }
+}
+
+JournalReader::~JournalReader() { std::fclose(f_); }
+
+bool JournalReader::next(JournalRecord& out) {
+    JournalRecord rec;
+    if (std::fread(&rec, sizeof rec, 1, f_) != 1) return false;
+    if (rec.lsn != last_lsn_ + 1 || rec.checksum != journal_checksum(rec)) return false;
+    out = rec;
+    last_lsn_     = rec.lsn;
+    valid_bytes_ += sizeof rec;
+    return true;
+}
+
+void JournalReader::skip_to(std::uint64_t lsn) {
+    const std::uint64_t offset = kHeaderSize + lsn * sizeof(JournalRecord);
+    if (std::fseek(f_, static_cast<long>(offset), SEEK_SET) != 0)
+        throw std::system_error(errno, std::generic_category(), "journal seek");
+    last_lsn_    = lsn;
+    valid_bytes_ = offset;
+}
+
+// ── Writer ────────────────────────────────────────────────────────────────────
+
+JournalWriter::JournalWriter(const std::string& path, JournalOptions opts)
+    : fd_(-1), opts_(opts), next_lsn_(1) {
+    pending_.reserve(opts_.batch_records);
+
+    // Find the end of the valid prefix of an existing journal.
+    std::uint64_t valid_bytes = 0;
+    if (journal_exists(path)) {
+        JournalReader r(path);
+        JournalRecord rec;
+        while (r.next(rec)) {}
+        valid_bytes = r.valid_bytes();
+        next_lsn_   = r.last_lsn() + 1;
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd_ < 0) throw_errno("open " + path);
+
+    if (valid_bytes == 0) {
+        Header h{};
+        std::memcpy(h.magic, kMagic, sizeof kMagic);
+        h.version     = kVersion;
+        h.record_size = sizeof(JournalRecord);
+        if (::ftruncate(fd_, 0) != 0) throw_errno("ftruncate " + path);
+        write_all(fd_, &h, sizeof h);
+        valid_bytes = sizeof h;
+    } else if (::ftruncate(fd_, static_cast<off_t>(valid_bytes)) != 0) {  // drop a torn tail
+        throw_errno("ftruncate " + path);
+    }
+    if (::lseek(fd_, static_cast<off_t>(valid_bytes), SEEK_SET) < 0) throw_errno("lseek " + path);
+
+    if (opts_.durability == Durability::Async) flusher_ = std::thread([this] { flusher_loop(); });
+}
+
+JournalWriter::~JournalWriter() {
+    try { commit(); } catch (...) {}
+    if (flusher_.joinable()) {
+        { std::lock_guard lk(sync_mtx_); stopping_ = true; }
+        sync_cv_.notify_one();
+        flusher_.join();
+    }
+    if (opts_.durability != Durability::None) ::fdatasync(fd_);
+    ::close(fd_);
+}
+
+std::uint64_t JournalWriter::append(const Command& cmd) {
+    JournalRecord rec{ next_lsn_++, cmd, 0 };
+    rec.checksum = journal_checksum(rec);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (pending_.empty()) oldest_pending_ = now;
+    pending_.push_back(rec);
+
+    if (pending_.size() >= opts_.batch_records || now - oldest_pending_ >= opts_.batch_interval)
+        commit();
+    return rec.lsn;
+}
+
+void JournalWriter::commit() {
+    if (pending_.empty()) return;
+    write_all(fd_, pending_.data(), pending_.size() * sizeof(JournalRecord));
+    pending_.clear();
+
+    switch (opts_.durability) {
+    case Durability::None:
+        break;
+    case Durability::Sync:
+        if (::fdatasync(fd_) != 0) throw_errno("journal fdatasync");
+        break;
+    case Durability::Async:
+        { std::lock_guard lk(sync_mtx_); dirty_ = true; }
+        break;
+    }
+}
+
+void JournalWriter::sync_to_disk() {
+    if (::fdatasync(fd_) != 0) throw_errno("journal fdatasync");
+}
+
+void JournalWriter::flusher_loop() {
+    std::unique_lock lk(sync_mtx_);
+    while (!stopping_) {
+        sync_cv_.wait_for(lk, opts_.sync_interval);
+        if (!dirty_) continue;
+        dirty_ = false;
+        lk.unlock();
+        ::fdatasync(fd_);  // the engine thread keeps appending meanwhile
+        lk.lock();
+    }
+}
+
+// ── Recovery ──────────────────────────────────────────────────────────────────
+
+std::uint64_t replay_journal(const std::string& path, OrderBook& ob, std::uint64_t after_lsn) {
+    if (!journal_exists(path)) return after_lsn;
+    JournalReader r(path);
+    r.skip_to(after_lsn);
+    JournalRecord rec;
+    while (r.next(rec)) (void)apply_command(ob, rec.cmd);
+    return r.last_lsn();
+}
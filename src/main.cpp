@@ -7,7 +7,44 @@
 #include <random>
 #include <chrono>
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <sys/prctl.h>
+#include <csignal>
+#include <memory>
+#include <atomic>
+#include <cerrno>
+#include <system_error>
+#include <unistd.h>
 #include "order_book.hpp"
+#include "journal.hpp"
+#include "snapshot.hpp"
+#include "mapped_book.hpp"
+#include "replay.hpp"
+#include "replication.hpp"
+#include "shm_ring.hpp"
+#include "latency.hpp"
+#include "workload.hpp"
+#include "perf_counters.hpp"
+#include "slow_log.hpp"
+#include "risk.hpp"
+#include "trace.hpp"
+
+// Engine-mode settings shared by interactive and shared-memory modes.
+struct EngineOptions {
+    std::string    journal_path;  // empty = no journal
+    JournalOptions journal;
+    std::string    snapshot_path;       // empty = no snapshots
+    std::string    mapped_snapshot_path;  // also write the mmap-able form (mapped_book.hpp)
+    std::uint64_t  snapshot_every = 0;  // accepted commands between snapshots (0 = SNAPSHOT only)
+    std::string    replicate_path;      // unix socket for followers; empty = none
+    std::string    trace_path;          // SIGUSR2 / TRACE dump target (LOB_TRACE builds)
+    std::uint64_t  slowlog_us  = 100;   // book calls slower than this go to SLOWLOG
+    std::size_t    slowlog_len = 128;   // entries kept (0 = off)
+    std::string    risk_path;           // per-account limits (risk.hpp); empty = no pre-trade checks
+};
 
 static Side parse_side(const std::string& s) {
     if (s == "BUY") return Side::Buy;
@@ -15,148 +52,915 @@ static Side parse_side(const std::string& s) {
     throw std::invalid_argument("Invalid side: " + s);
 }
 
-static void print_trades(const std::vector<Trade>& trades) {
+// Reads the optional OWNER / STP words that may follow an ADD or MARKET.
+static Command with_options(Command c, std::istringstream& ss) {
+    std::string rest;
+    std::getline(ss, rest);
+    parse_order_options(rest, c);
+    return c;
+}
+
+static void print_trades(std::ostream& out, const std::vector<Trade>& trades, const std::string& prefix = "") {
     for (const auto& t : trades) {
-        std::cout << "TRADE price=" << t.price
-                  << " qty=" << t.qty
-                  << " buy=" << t.buy_id
-                  << " sell=" << t.sell_id << "\n";
+        out << prefix << "TRADE price=" << t.price
+            << " qty=" << t.qty
+            << " buy=" << t.buy_id
+            << " sell=" << t.sell_id << "\n";
     }
 }
 
+static void print_book(std::ostream& out, const OrderBook& ob, const std::string& prefix) {
+    const Touch t = ob.touch();
+    out << prefix << "BOOK best_bid=" << (t.bid ? std::to_string(*t.bid) : "none")
+        << " best_ask=" << (t.ask ? std::to_string(*t.ask) : "none") << "\n";
+}
+
+// Recovers `ob` from the latest snapshot plus the journal records after it
+// (either may be absent) and opens the journal for appending. `risk`, if
+// given, is seeded from the snapshot and listens to the replay, so positions
+// come back as they were.
+static std::unique_ptr<JournalWriter> open_journal(const EngineOptions& opts, OrderBook& ob, RiskEngine* risk) {
+    if (risk) ob.set_listener(risk);
+    std::uint64_t from = 0;
+    if (!opts.snapshot_path.empty()) {
+        if (auto image = load_snapshot_file(opts.snapshot_path)) {
+            ob.restore(*image);
+            if (risk) risk->seed(*image);
+            from = image->lsn;
+            std::cerr << "Restored " << image->orders.size() << " orders from "
+                      << opts.snapshot_path << " (lsn " << from << ")\n";
+        }
+    }
+    if (opts.journal_path.empty()) return nullptr;
+
+    const auto lsn = replay_journal(opts.journal_path, ob, from);
+    if (lsn > from) std::cerr << "Recovered " << lsn - from << " commands from " << opts.journal_path << "\n";
+    auto journal = std::make_unique<JournalWriter>(opts.journal_path, opts.journal);
+    if (journal->last_lsn() < from)
+        throw std::runtime_error("journal " + opts.journal_path + " ends before snapshot lsn " + std::to_string(from));
+    return journal;
+}
+
+// Takes snapshots for the engine loops. The book is copied on the engine
+// thread (the only time matching stalls); fsyncing the journal up to the
+// image's lsn and writing the file happen on a background thread. At most
+// one snapshot is in flight; a due snapshot is retried on later commands.
+class Snapshotter {
+public:
+    Snapshotter(const EngineOptions& opts, JournalWriter* journal, const RiskEngine* risk)
+        : path_(opts.snapshot_path), mapped_path_(opts.mapped_snapshot_path),
+          every_(opts.snapshot_every), journal_(journal), risk_(risk) {}
+    ~Snapshotter() { if (worker_.joinable()) worker_.join(); }
+    Snapshotter(const Snapshotter&) = delete;
+    Snapshotter& operator=(const Snapshotter&) = delete;
+
+    // Call once per accepted command.
+    void on_accepted(const OrderBook& ob) {
+        if (every_ == 0 || ++since_ < every_) return;
+        if (take(ob)) since_ = 0;
+    }
+
+    // Starts a snapshot; false if disabled or one is still being written.
+    bool take(const OrderBook& ob) {
+        if ((path_.empty() && mapped_path_.empty()) || busy_.load(std::memory_order_acquire)) return false;
+        if (worker_.joinable()) worker_.join();
+
+        if (journal_) journal_->commit();
+        BookImage image = ob.capture();
+        image.lsn = journal_ ? journal_->last_lsn() : 0;
+        if (risk_) risk_->save(image);
+
+        busy_.store(true, std::memory_order_release);
+        worker_ = std::thread([this, image = std::move(image)] {
+            try {
+                // The snapshot must never get ahead of the durable journal.
+                if (journal_) journal_->sync_to_disk();
+                if (!path_.empty())        write_snapshot_file(path_, image);
+                if (!mapped_path_.empty()) write_mapped_snapshot_file(mapped_path_, image);
+            } catch (const std::exception& e) {
+                std::cerr << "Snapshot failed: " << e.what() << "\n";
+            }
+            busy_.store(false, std::memory_order_release);
+        });
+        return true;
+    }
+
+private:
+    std::string       path_;
+    std::string       mapped_path_;
+    std::uint64_t     every_;
+    JournalWriter*    journal_;
+    const RiskEngine* risk_;
+    std::uint64_t     since_ = 0;
+    std::atomic<bool> busy_{false};
+    std::thread       worker_;
+};
+
+// Everything an accepted command has to reach besides the book. Members are
+// declared in dependency order: the snapshotter uses the journal. `risk` is
+// the engine's (see open_risk), whose positions snapshots carry.
+struct EngineSinks {
+    RiskEngine*                         risk = nullptr;
+    std::unique_ptr<JournalWriter>      journal;
+    std::unique_ptr<Snapshotter>        snapshots;
+    std::unique_ptr<ReplicationPrimary> replicas;
+
+    // Whether replies must be held until end_batch().
+    [[nodiscard]] bool batching() const { return journal || replicas; }
+
+    void accepted(const Command& c, const OrderBook& ob) {
+        if (journal)  journal->append(c);
+        if (replicas) {
+            replicas->append(c);
+            // Streams a long burst, but never ahead of the journal.
+            if (replicas->send_due()) {
+                if (journal) journal->commit();
+                replicas->send();
+            }
+        }
+        snapshots->on_accepted(ob);
+    }
+
+    // Commits the journal and ships the batch to followers; call before the
+    // batch's replies are released.
+    void end_batch(const OrderBook& ob) {
+        if (journal)  journal->commit();
+        if (replicas) replicas->flush(ob, risk);
+    }
+};
+
+// Recovers `ob` and `risk` (see open_journal) and opens the sinks configured
+// in `opts`. `last_lsn` numbers replication records when there is no journal
+// to follow (a promoted follower continues its primary's sequence).
+static EngineSinks open_sinks(const EngineOptions& opts, OrderBook& ob, RiskEngine* risk,
+                              std::uint64_t last_lsn = 0) {
+    EngineSinks sinks;
+    sinks.risk      = risk;
+    sinks.journal   = open_journal(opts, ob, risk);
+    sinks.snapshots = std::make_unique<Snapshotter>(opts, sinks.journal.get(), risk);
+    if (!opts.replicate_path.empty()) {
+        sinks.replicas = std::make_unique<ReplicationPrimary>(
+            opts.replicate_path, sinks.journal ? sinks.journal->last_lsn() : last_lsn);
+    }
+    return sinks;
+}
+
+// Collects the market data of the current command for SUBSCRIBE L2 / L3.
+class MarketDataFeed : public BookListener {
+public:
+    bool l2 = false;
+    bool l3 = false;
+
+    void on_level(const LevelUpdate& u) override { if (l2) levels_.push_back(u); }
+    void on_order(const OrderEvent& e) override  { if (l3) orders_.push_back(e); }
+
+    // Prints and clears the collected events: L3 first (in sequence), then L2.
+    void print(std::ostream& out, const std::string& prefix) {
+        for (const auto& e : orders_) print_order(out, e, prefix);
+        for (const auto& u : levels_) print_level(out, u.side, u.level, prefix);
+        orders_.clear();
+        levels_.clear();
+    }
+
+    static void print_level(std::ostream& out, Side side, const DepthLevel& l, const std::string& prefix) {
+        out << prefix << "L2 side=" << side_name(side)
+            << " price=" << l.price << " qty=" << l.qty << " orders=" << l.count << "\n";
+    }
+
+    static void print_order(std::ostream& out, const OrderEvent& e, const std::string& prefix) {
+        static constexpr const char* kTypes[] = { "?", "ADD", "EXEC", "CANCEL", "REDUCE" };
+        out << prefix << "L3 seq=" << e.event_seq << " type=" << kTypes[static_cast<int>(e.type)]
+            << " id=" << e.id << " side=" << side_name(e.side) << " price=" << e.price
+            << " qty=" << e.qty << " remaining=" << e.remaining << " order_seq=" << e.order_seq;
+        if (e.type == OrderEventType::Execute) out << " contra=" << e.contra;
+        out << "\n";
+    }
+
+private:
+    static const char* side_name(Side s) { return s == Side::Buy ? "BUY" : "SELL"; }
+
+    std::vector<LevelUpdate> levels_;
+    std::vector<OrderEvent>  orders_;
+};
+
+// Latency of the book call behind each ADD / MARKET / CANCEL, and the number
+// of ERROR replies, for STATS. Owned by the command loop, its only writer.
+struct CommandStats {
+    LatencyHistogram add, market, cancel;
+    std::uint64_t    errors = 0;
+};
+
+static void print_stats(std::ostream& out, const OrderBook& ob, const CommandStats& cs, const std::string& prefix) {
+    const BookStats s = ob.stats();
+    out << prefix << "STATS added=" << s.added << " cancelled=" << s.cancelled << " filled=" << s.filled
+        << " trades=" << s.trades << " rejected=" << s.rejected << " levels=" << s.levels
+        << " resting=" << s.resting << " peak_levels=" << s.peak_levels << " prevented=" << s.prevented
+        << " errors=" << cs.errors << "\n";
+    auto ns = [](std::uint64_t ticks) { return CycleClock::to_ns(ticks); };
+    auto latency = [&](const char* op, const LatencyHistogram& h) {
+        const auto sum = static_cast<std::uint64_t>(h.mean() * static_cast<double>(h.count()) * CycleClock::ns_per_tick());
+        out << prefix << "LATENCY op=" << op << " count=" << h.count() << " sum_ns=" << sum
+            << " p50_ns=" << ns(h.percentile(50)) << " p90_ns=" << ns(h.percentile(90))
+            << " p99_ns=" << ns(h.percentile(99)) << " p99.9_ns=" << ns(h.percentile(99.9))
+            << " max_ns=" << ns(h.max()) << "\n";
+    };
+    latency("add", cs.add);
+    latency("market", cs.market);
+    latency("cancel", cs.cancel);
+}
+
+static void print_slowlog(std::ostream& out, const SlowLog& log, std::size_t max, const std::string& prefix) {
+    static const char* const kType[] = { "?", "ADD", "MARKET", "CANCEL", "STATUS", "DEPTH" };
+    auto levels = [](const std::vector<DepthLevel>& side) {
+        if (side.empty()) return std::string("-");
+        std::string out;
+        for (const auto& l : side) {
+            if (!out.empty()) out += ',';
+            out += std::to_string(l.price) + 'x' + std::to_string(l.qty);
+        }
+        return out;
+    };
+    const auto entries = log.entries(max);
+    out << prefix << "SLOWLOG entries=" << entries.size() << " total=" << log.total()
+        << " threshold_ns=" << log.threshold_ns() << "\n";
+    for (const auto& e : entries) {
+        const Command& c = e.cmd;
+        out << prefix << "SLOW seq=" << e.seq << " unix_us=" << e.unix_us << " dur_ns=" << e.ns
+            << " cmd=" << kType[static_cast<int>(c.type)] << " id=" << c.id;
+        if (c.type != CommandType::Cancel) out << " side=" << (c.side == Side::Buy ? "BUY" : "SELL");
+        if (c.type == CommandType::Add) out << " price=" << c.price;
+        if (c.type != CommandType::Cancel) out << " qty=" << c.qty;
+        out << " levels=" << e.levels << " fills=" << e.fills
+            << " bids=" << levels(e.top.bids) << " asks=" << levels(e.top.asks) << "\n";
+    }
+}
+
+// ── Pre-trade risk (--risk) ───────────────────────────────────────────────────
+// With --risk, the pre-trade engine loaded from the config; nullptr without.
+// It is opened before the book is recovered: open_sinks() seeds it from the
+// snapshot and has it follow the journal replay (run_follower, the
+// replication stream), so positions survive restarts and promotions.
+static std::unique_ptr<RiskEngine> open_risk(const EngineOptions& opts) {
+    if (opts.risk_path.empty()) return nullptr;
+    auto risk = std::make_unique<RiskEngine>();
+    risk->load(opts.risk_path);
+    return risk;
+}
+
+// Throws "risk: <limit>" when the order's account may not send it.
+static void check_risk(RiskEngine* risk, const Command& c, const OrderBook& ob) {
+    if (!risk) return;
+    const Touch t = ob.touch();
+    const RiskReject r = risk->check(c.owner, c.side, c.type == CommandType::Add ? c.price : 0, c.qty, t.bid, t.ask);
+    if (r != RiskReject::None) throw std::invalid_argument(std::string("risk: ") + risk_reject_name(r));
+}
+
+// The risk engine sees every order event first and passes them on to `feed`.
+static void route_events(OrderBook& ob, RiskEngine* risk, BookListener* feed) {
+    if (!risk) { ob.set_listener(feed); return; }
+    risk->forward_to(feed);
+    ob.set_listener(risk);
+}
+
 // ── Interactive / streaming mode ──────────────────────────────────────────────
 // Used by FastAPI subprocess bridge.
-// Reads commands from stdin line-by-line, writes results to stdout immediately.
+// Reads commands from stdin line-by-line, writes results to stdout.
 // Every response ends with "OK\n" or "ERROR <msg>\n".
-static int run_interactive() {
+//
+// ADD and MARKET may end with "OWNER <account>" and "STP <mode>": the order
+// then never trades against a resting order of the same owner, and <mode>
+// (CANCEL_NEWEST, the default, | CANCEL_OLDEST | CANCEL_BOTH | DECREMENT)
+// says what happens instead (StpMode in order_book.hpp).
+//
+// Pipelining: a command may be prefixed with a request tag, "@<tag> ADD ...".
+// Every reply line of a tagged command is then prefixed with the same
+// "@<tag> ", so a client can keep many commands in flight and demultiplex the
+// replies. Replies are collected per batch and written once stdin has no
+// more buffered input (or kReplyBatch commands were read), so a burst of
+// pipelined commands is answered with a single write.
+//
+// With a journal, every accepted command is appended to it, and the pending
+// batch is committed before the batch's replies are written: no reply leaves
+// the process before the commands it acknowledges are in the journal, however
+// large the burst.
+//
+// Market data: after "SUBSCRIBE L2", ADD / MARKET / CANCEL replies also carry
+// one "L2 side=<BUY|SELL> price=<p> qty=<total> orders=<n>" line per level
+// the command changed (qty=0 orders=0: level removed), after the BOOK line.
+// "L2SNAPSHOT" replies with "L2SNAPSHOT bids=<n> asks=<m>" followed by an L2
+// line for every level: the base a subscriber applies those deltas to.
+// "SUBSCRIBE L3" adds one "L3 seq=<n> type=<ADD|EXEC|CANCEL|REDUCE> ..." line per
+// order event (before the L2 lines). seq is gap-free; on a gap, "L3SNAPSHOT"
+// replies "L3SNAPSHOT seq=<n> orders=<m>" and one "L3ORDER" line per resting
+// order in priority order, reflecting every event up to seq.
+// "UNSUBSCRIBE L2|L3" stops a feed.
+//
+// "DEPTH <n>" replies "DEPTH bids=<b> asks=<a>" followed by L2 lines for the
+// best n levels per side, bids first; the per-level totals are maintained by
+// the book, so the reply costs O(n) whatever the number of resting orders.
+//
+// "SLOWLOG [n]" replies "SLOWLOG entries=.. total=.. threshold_ns=.." and
+// the newest n (default all kept) "SLOW seq=.. unix_us=.. dur_ns=.. cmd=..
+// id=.. [side=.. price=.. qty=..] levels=.. fills=.. bids=<p>x<q>,..
+// asks=.." lines: ADD / MARKET / CANCEL calls slower than --slowlog-us, with
+// the top of the book right after them ("-": empty side). levels counts the
+// price levels filled against; levels only walked through self-trade
+// prevention count 0. "SLOWLOG RESET" empties it.
+//
+// "TRACE [path]" (LOB_TRACE builds) dumps the trace rings to path, default
+// --trace-out, and replies "TRACE records=<n> path=<p>"; SIGUSR2 dumps to
+// --trace-out as well, without going through the command loop. Decode with
+// lob_trace_decode.
+//
+// With --risk, ADD and MARKET are checked against the owner's limits (see
+// risk.hpp) before reaching the book; a breach replies "ERROR risk: <limit>"
+// and is not journaled. Positions are recovered with the book: snapshots
+// carry them, and replay and replication move them. "RISK <account>
+// [key=value ...]" changes that
+// account's limits and replies "RISK account=.. position=.. open_orders=..
+// open_buy_qty=.. open_sell_qty=.. rejects=.. max_qty=.. max_notional=..
+// max_open=.. band=.. max_position=.." (limits 0: none).
+//
+// "HASH" prints the book's rolling state and trade hashes (BookHash), which
+// match those of any other engine or replay that processed the same commands.
+//
+// "STATS" replies "STATS added=.. cancelled=.. filled=.. trades=.. rejected=..
+// levels=.. resting=.. peak_levels=.. prevented=.. errors=.." (BookStats plus the number of
+// ERROR replies) and one "LATENCY op=<add|market|cancel> count=.. sum_ns=..
+// p50_ns=.. ... max_ns=.." line per operation: the time spent in the book
+// call, recorded for every command since startup.
+//
+// With --snapshot, "SNAPSHOT" writes one in the background (also taken every
+// --snapshot-every accepted commands); it replies "SNAPSHOT BUSY" while the
+// previous one is still being written.
+//
+// With --replicate, accepted commands are shipped to followers at the same
+// point the journal is committed. A follower that connects while the engine
+// is idle is synced at the next command.
+//
+// `ob` is empty, or a promoted follower's book (see run_follower), `risk`
+// then the risk engine that followed it.
+static int run_interactive(const EngineOptions& opts, OrderBook& ob, std::uint64_t last_lsn = 0,
+                           std::unique_ptr<RiskEngine> risk = nullptr) {
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
-    OrderBook ob;
+    if (!risk) risk = open_risk(opts);
+    EngineSinks sinks = open_sinks(opts, ob, risk.get(), last_lsn);
+    MarketDataFeed feed;
+    CommandStats stats;
+    SlowLog slow(opts.slowlog_us * 1000, opts.slowlog_len);  // also calibrates the clock
+    route_events(ob, risk.get(), nullptr);
     std::string line;
 
+    // Replies of the current batch; written to stdout only after end_batch().
+    constexpr std::size_t kReplyBatch = 1024;  // commands per batch, at most
+    std::ostringstream out;
+    std::size_t batched = 0;
+    auto release = [&] {
+        sinks.end_batch(ob);
+        std::cout << out.str();
+        std::cout.flush();
+        out.str("");
+        batched = 0;
+    };
+
     std::cout << "READY\n";
     std::cout.flush();
 
     while (std::getline(std::cin, line)) {
-        std::size_t i = 0;
-        while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i;
-        if (i == line.size() || line[i] == '#') {
-            std::cout << "OK\n";
-            std::cout.flush();
-            continue;
-        }
-
         std::istringstream ss(line);
         std::string cmd;
+        std::string prefix;
         ss >> cmd;
+        if (!cmd.empty() && cmd[0] == '@') {
+            prefix = cmd + " ";
+            cmd.clear();
+            ss >> cmd;
+        }
 
         try {
-            if (cmd == "ADD") {
+            if (cmd.empty() || cmd[0] == '#') {
+                out << prefix << "OK\n";
+
+            } else if (cmd == "ADD") {
                 OrderId id; std::string side_s; std::int64_t price, qty;
                 ss >> id >> side_s >> price >> qty;
-                auto trades = ob.add_limit(id, parse_side(side_s), price, qty);
-                print_trades(trades);
-                auto bid = ob.best_bid(); auto ask = ob.best_ask();
-                std::cout << "BOOK best_bid=" << (bid ? std::to_string(*bid) : "none")
-                          << " best_ask=" << (ask ? std::to_string(*ask) : "none") << "\n";
-                std::cout << "OK\n";
+                const Command c = with_options(Command{ id, price, qty, CommandType::Add, parse_side(side_s), {} }, ss);
+                check_risk(risk.get(), c, ob);
+                const std::uint64_t t0 = CycleClock::now();
+                auto trades = ob.add_limit(id, c.side, price, qty, c.owner, c.stp);
+                const std::uint64_t dt = CycleClock::now() - t0;
+                stats.add.record(dt);
+                slow.offer(c, dt, trades, ob);
+                sinks.accepted(c, ob);
+                print_trades(out, trades, prefix);
+                print_book(out, ob, prefix);
+                feed.print(out, prefix);
+                out << prefix << "OK\n";
 
             } else if (cmd == "MARKET") {
                 OrderId id; std::string side_s; std::int64_t qty;
                 ss >> id >> side_s >> qty;
-                auto trades = ob.add_market(id, parse_side(side_s), qty);
-                print_trades(trades);
-                auto bid = ob.best_bid(); auto ask = ob.best_ask();
-                std::cout << "BOOK best_bid=" << (bid ? std::to_string(*bid) : "none")
-                          << " best_ask=" << (ask ? std::to_string(*ask) : "none") << "\n";
-                std::cout << "OK\n";
+                const Command c = with_options(Command{ id, 0, qty, CommandType::Market, parse_side(side_s), {} }, ss);
+                check_risk(risk.get(), c, ob);
+                const std::uint64_t t0 = CycleClock::now();
+                auto trades = ob.add_market(id, c.side, qty, c.owner, c.stp);
+                const std::uint64_t dt = CycleClock::now() - t0;
+                stats.market.record(dt);
+                slow.offer(c, dt, trades, ob);
+                sinks.accepted(c, ob);
+                print_trades(out, trades, prefix);
+                print_book(out, ob, prefix);
+                feed.print(out, prefix);
+                out << prefix << "OK\n";
 
             } else if (cmd == "CANCEL") {
                 OrderId id; ss >> id;
+                const Command c{ id, 0, 0, CommandType::Cancel, Side::Buy, {} };
+                const std::uint64_t t0 = CycleClock::now();
                 bool ok = ob.cancel(id);
-                std::cout << "CANCEL id=" << id << " " << (ok ? "OK" : "NOT_FOUND") << "\n";
-                auto bid = ob.best_bid(); auto ask = ob.best_ask();
-                std::cout << "BOOK best_bid=" << (bid ? std::to_string(*bid) : "none")
-                          << " best_ask=" << (ask ? std::to_string(*ask) : "none") << "\n";
-                std::cout << "OK\n";
+                const std::uint64_t dt = CycleClock::now() - t0;
+                stats.cancel.record(dt);
+                slow.offer(c, dt, {}, ob);
+                if (ok) sinks.accepted(c, ob);
+                out << prefix << "CANCEL id=" << id << " " << (ok ? "OK" : "NOT_FOUND") << "\n";
+                print_book(out, ob, prefix);
+                feed.print(out, prefix);
+                out << prefix << "OK\n";
 
             } else if (cmd == "STATUS") {
-                auto bid = ob.best_bid(); auto ask = ob.best_ask();
-                std::cout << "BOOK best_bid=" << (bid ? std::to_string(*bid) : "none")
-                          << " best_ask=" << (ask ? std::to_string(*ask) : "none") << "\n";
-                std::cout << "OK\n";
+                print_book(out, ob, prefix);
+                out << prefix << "OK\n";
+
+            } else if (cmd == "SUBSCRIBE" || cmd == "UNSUBSCRIBE") {
+                std::string name; ss >> name;
+                const bool on = (cmd == "SUBSCRIBE");
+                if      (name == "L2") feed.l2 = on;
+                else if (name == "L3") feed.l3 = on;
+                else throw std::invalid_argument("Unknown feed: " + name);
+                route_events(ob, risk.get(), feed.l2 || feed.l3 ? &feed : nullptr);
+                out << prefix << "OK\n";
+
+            } else if (cmd == "L2SNAPSHOT") {
+                const BookDepth d = ob.depth();
+                out << prefix << "L2SNAPSHOT bids=" << d.bids.size() << " asks=" << d.asks.size() << "\n";
+                for (const auto& l : d.bids) MarketDataFeed::print_level(out, Side::Buy, l, prefix);
+                for (const auto& l : d.asks) MarketDataFeed::print_level(out, Side::Sell, l, prefix);
+                out << prefix << "OK\n";
+
+            } else if (cmd == "DEPTH") {
+                std::int64_t n = 0; ss >> n;
+                if (!ss || n <= 0) throw std::invalid_argument("DEPTH levels must be positive");
+                const BookDepth d = ob.depth(static_cast<std::size_t>(n));
+                out << prefix << "DEPTH bids=" << d.bids.size() << " asks=" << d.asks.size() << "\n";
+                for (const auto& l : d.bids) MarketDataFeed::print_level(out, Side::Buy, l, prefix);
+                for (const auto& l : d.asks) MarketDataFeed::print_level(out, Side::Sell, l, prefix);
+                out << prefix << "OK\n";
+
+            } else if (cmd == "L3SNAPSHOT") {
+                const BookImage img = ob.capture();
+                out << prefix << "L3SNAPSHOT seq=" << img.event_seq << " orders=" << img.orders.size() << "\n";
+                for (const auto& o : img.orders) {
+                    out << prefix << "L3ORDER id=" << o.id << " side=" << (o.side == Side::Buy ? "BUY" : "SELL")
+                        << " price=" << o.price << " qty=" << o.qty << " order_seq=" << o.seq << "\n";
+                }
+                out << prefix << "OK\n";
+
+            } else if (cmd == "RISK") {
+                if (!risk) throw std::invalid_argument("no --risk config");
+                AccountId account; ss >> account;
+                if (!ss) throw std::invalid_argument("RISK takes an account");
+                if (account > risk->max_account()) throw std::invalid_argument("account above " + std::to_string(risk->max_account()));
+                std::string rest; std::getline(ss, rest);
+                if (rest.find_first_not_of(" \t\r") != std::string::npos)
+                    risk->set_limits(account, parse_risk_limits(rest, risk->limits(account)));
+                const AccountRisk a = risk->account(account);
+                const RiskLimits  l = risk->limits(account);
+                out << prefix << "RISK account=" << account << " position=" << a.position
+                    << " open_orders=" << a.open_orders << " open_buy_qty=" << a.open_buy_qty
+                    << " open_sell_qty=" << a.open_sell_qty << " rejects=" << a.rejects
+                    << " max_qty=" << l.max_qty << " max_notional=" << l.max_notional
+                    << " max_open=" << l.max_open << " band=" << l.band << " max_position=" << l.max_position << "\n";
+                out << prefix << "OK\n";
+
+            } else if (cmd == "HASH") {
+                const BookHash h = ob.hash();
+                char buf[80];
+                std::snprintf(buf, sizeof buf, "HASH state=%016llx trades=%016llx",
+                              static_cast<unsigned long long>(h.state),
+                              static_cast<unsigned long long>(h.trades));
+                out << prefix << buf << " trade_count=" << h.trade_count << "\n";
+                out << prefix << "OK\n";
+
+            } else if (cmd == "STATS") {
+                print_stats(out, ob, stats, prefix);
+                out << prefix << "OK\n";
+
+            } else if (cmd == "SLOWLOG") {
+                std::string arg; ss >> arg;
+                if (arg == "RESET") {
+                    slow.clear();
+                } else {
+                    const std::size_t n = arg.empty() ? SIZE_MAX : std::stoull(arg);
+                    print_slowlog(out, slow, n, prefix);
+                }
+                out << prefix << "OK\n";
+
+            } else if (cmd == "TRACE") {
+                if (!trace_enabled()) throw std::invalid_argument("built without LOB_TRACE (cmake -DLOB_TRACE=ON)");
+                std::string path = opts.trace_path;
+                ss >> path;
+                const long n = trace_dump(path.c_str());
+                if (n < 0) throw std::system_error(errno, std::generic_category(), "trace dump to " + path);
+                out << prefix << "TRACE records=" << n << " path=" << path << "\n";
+                out << prefix << "OK\n";
+
+            } else if (cmd == "SNAPSHOT") {
+                if (opts.snapshot_path.empty() && opts.mapped_snapshot_path.empty()) throw std::invalid_argument("no --snapshot path configured");
+                if (!sinks.snapshots->take(ob)) out << prefix << "SNAPSHOT BUSY\n";
+                out << prefix << "OK\n";
 
             } else {
-                std::cout << "ERROR Unknown command: " << cmd << "\n";
+                ++stats.errors;
+                out << prefix << "ERROR Unknown command: " << cmd << "\n";
             }
         } catch (const std::exception& e) {
-            std::cout << "ERROR " << e.what() << "\n";
+            ++stats.errors;
+            out << prefix << "ERROR " << e.what() << "\n";
         }
-        std::cout.flush();
+        if (++batched >= kReplyBatch || std::cin.rdbuf()->in_avail() <= 0) release();
     }
+    release();
+    ob.set_listener(nullptr);
     return 0;
 }
 
-// ── Benchmark (unchanged) ─────────────────────────────────────────────────────
-static int run_bench(std::size_t n) {
+// ── Shared-memory mode ────────────────────────────────────────────────────────
+// Used by api/shm_client.py. Same commands and replies as interactive mode,
+// exchanged as fixed-size records through the rings in /dev/shm/<name>
+// (layout documented in shm_ring.hpp). Exits once the client marks the
+// channel closed and the command ring is drained.
+//
+// With a journal or followers, replies are held back per batch (until the
+// command ring is empty or kShmBatch commands were applied) and only
+// published after the batch has been committed and replicated, as in
+// interactive mode.
+static ShmEvent book_event(std::uint64_t tag, const OrderBook& ob) {
+    ShmEvent ev{};
+    ev.tag  = tag;
+    ev.type = ShmEventType::Book;
+    const Touch t = ob.touch();
+    if (t.bid) { ev.a = *t.bid; ev.flags |= 1; }
+    if (t.ask) { ev.b = *t.ask; ev.flags |= 2; }
+    return ev;
+}
+
+static int run_shm(const std::string& name, const EngineOptions& opts) {
+    // Don't outlive the client: nothing else would ever close the channel.
+    ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+    ShmChannel ch = ShmChannel::attach("/dev/shm/" + name);
     OrderBook ob;
-    const std::size_t sample_every = 1000;
-    std::vector<double> lat_us;
-    lat_us.reserve(n / sample_every + 1);
-    std::mt19937_64 rng(42);
-    std::uniform_int_distribution<int> op_dist(0, 99);
-    std::uniform_int_distribution<int> side_dist(0, 1);
-    std::uniform_int_distribution<int> px_dist(95, 105);
-    std::uniform_int_distribution<int> qty_dist(1, 10);
-    std::uniform_int_distribution<int> mkt_qty_dist(1, 5);
-    std::vector<OrderId> active_ids;
-    active_ids.reserve(n / 2);
-    OrderId next_id = 1;
-    std::size_t adds=0, cancels=0, markets=0, trades_count=0, cancel_ok=0, cancel_miss=0;
-    auto start = std::chrono::steady_clock::now();
-    for (std::size_t i = 0; i < n; ++i) {
-        bool sample = (i % sample_every == 0);
-        auto t0 = sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
-        int op = op_dist(rng);
-        if (op < 70) {
-            Side side = (side_dist(rng)==0)?Side::Buy:Side::Sell;
-            OrderId id = next_id++;
-            auto trades = ob.add_limit(id, side, px_dist(rng), qty_dist(rng));
-            trades_count += trades.size();
-            active_ids.push_back(id); ++adds;
-        } else if (op < 90) {
-            if (!active_ids.empty()) {
-                std::uniform_int_distribution<std::size_t> idx_dist(0, active_ids.size()-1);
-                std::size_t idx = idx_dist(rng);
-                bool ok = ob.cancel(active_ids[idx]);
-                if (ok) ++cancel_ok; else ++cancel_miss;
-                active_ids[idx] = active_ids.back(); active_ids.pop_back(); ++cancels;
+    const auto risk = open_risk(opts);
+    EngineSinks sinks = open_sinks(opts, ob, risk.get());
+    route_events(ob, risk.get(), nullptr);
+    ch.set_engine_state(1);
+
+    constexpr std::size_t kShmBatch = 256;
+    std::vector<ShmEvent> outbox;
+    std::size_t batched = 0;
+
+    auto publish = [&](const ShmEvent& ev) {
+        while (!ch.push_event(ev)) std::this_thread::yield();
+    };
+    auto emit = [&](const ShmEvent& ev) {
+        if (sinks.batching()) outbox.push_back(ev); else publish(ev);
+    };
+    auto end_batch = [&] {
+        if (!sinks.batching()) return;
+        sinks.end_batch(ob);
+        for (const auto& ev : outbox) publish(ev);
+        outbox.clear();
+        batched = 0;
+    };
+
+    ShmCommand in{};
+    unsigned idle = 0;
+    for (;;) {
+        if (!ch.pop_command(in)) {
+            if (batched > 0 || (sinks.replicas && idle % 1024 == 0)) end_batch();  // also admits new followers
+            if (ch.client_state() == 2) break;
+            // Spin briefly, then back off so an idle engine doesn't burn a core.
+            if (++idle > 1000) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        idle = 0;
+
+        const Command& c = in.cmd;
+        ShmEvent ev{};
+        ev.tag = in.tag;
+        try {
+            switch (c.type) {
+            case CommandType::Add:
+            case CommandType::Market: {
+                check_risk(risk.get(), c, ob);
+                auto trades = apply_command(ob, c);
+                sinks.accepted(c, ob);
+                for (const auto& t : trades) {
+                    ShmEvent tr{};
+                    tr.tag = in.tag; tr.type = ShmEventType::Trade;
+                    tr.a = t.price; tr.b = t.qty; tr.c = t.buy_id; tr.d = t.sell_id;
+                    emit(tr);
+                }
+                break;
+            }
+            case CommandType::Cancel: {
+                ShmEvent cx{};
+                cx.tag = in.tag; cx.type = ShmEventType::Cancel; cx.c = c.id;
+                cx.flags = ob.cancel(c.id) ? 1 : 0;
+                if (cx.flags) sinks.accepted(c, ob);
+                emit(cx);
+                break;
+            }
+            case CommandType::Status:
+                break;
+            case CommandType::Depth: {
+                if (c.qty <= 0) throw std::invalid_argument("DEPTH levels must be positive");
+                const BookDepth d = ob.depth(static_cast<std::size_t>(c.qty));
+                for (const auto* side : { &d.bids, &d.asks }) {
+                    for (const auto& l : *side) {
+                        ShmEvent lv{};
+                        lv.tag = in.tag; lv.type = ShmEventType::Level;
+                        lv.flags = side == &d.asks ? 1 : 0;
+                        lv.a = l.price; lv.b = l.qty; lv.c = l.count;
+                        emit(lv);
+                    }
+                }
+                break;
             }
-        } else {
-            Side side = (side_dist(rng)==0)?Side::Buy:Side::Sell;
-            auto trades = ob.add_market(next_id++, side, mkt_qty_dist(rng));
-            trades_count += trades.size(); ++markets;
+            default:
+                throw std::invalid_argument("Unknown command type");
+            }
+            emit(book_event(in.tag, ob));
+            ev.type = ShmEventType::Ok;
+        } catch (const std::exception& e) {
+            ev.type = ShmEventType::Error;
+            // NUL-padded, truncated to the 32 bytes of a..d (no terminator when full).
+            char* msg = reinterpret_cast<char*>(&ev) + offsetof(ShmEvent, a);
+            constexpr std::size_t kMsg = sizeof(ShmEvent) - offsetof(ShmEvent, a);
+            std::memset(msg, 0, kMsg);
+            std::memcpy(msg, e.what(), std::min(std::strlen(e.what()), kMsg));
         }
-        if (sample) {
-            auto t1 = std::chrono::steady_clock::now();
-            std::chrono::duration<double,std::micro> us = t1-t0;
-            lat_us.push_back(us.count());
+        emit(ev);
+        if (sinks.batching() && ++batched >= kShmBatch) end_batch();
+    }
+    end_batch();
+    ob.set_listener(nullptr);
+    ch.set_engine_state(2);
+    return 0;
+}
+
+// ── Follower mode ─────────────────────────────────────────────────────────────
+// Hot standby for a primary started with --replicate <socket>. Applies the
+// primary's command stream to its own book without reading stdin; when the
+// stream ends (the primary exited or crashed) or on SIGUSR1, it is promoted:
+// it continues as an interactive engine with the replicated book, printing
+// READY as a freshly started engine would. It may itself --replicate.
+static std::atomic<bool> g_promote{false};
+
+static int run_follower(const std::string& socket_path, const EngineOptions& opts) {
+    if (!opts.journal_path.empty() || !opts.snapshot_path.empty())
+        throw std::invalid_argument("--follow takes its state from the primary; drop --journal / --snapshot");
+
+    struct sigaction sa{};
+    sa.sa_handler = [](int) { g_promote.store(true, std::memory_order_relaxed); };
+    ::sigaction(SIGUSR1, &sa, nullptr);
+
+    OrderBook ob;
+    auto risk = open_risk(opts);
+    route_events(ob, risk.get(), nullptr);
+    ReplicationFollower follower(socket_path);
+    std::cerr << "Following " << socket_path << "\n";
+    while (!g_promote.load(std::memory_order_relaxed) && follower.poll(ob, 100, risk.get())) {}
+
+    if (!follower.synced()) throw std::runtime_error("primary went away before the follower was synced");
+    std::cerr << "Promoted at lsn " << follower.last_lsn() << "\n";
+    return run_interactive(opts, ob, follower.last_lsn(), std::move(risk));
+}
+
+// ── Benchmark ─────────────────────────────────────────────────────────────────
+// Every operation is timed with the cycle counter into a histogram per
+// operation type. One BENCH_LAT line per type reports the tail; with
+// --hist-out <prefix>, the full distributions are written to
+// <prefix>.<op>.hgrm in HdrHistogram's percentile format.
+//
+// Closed loop (default): each operation is issued as soon as the previous
+// one returns and timed on its own, so a stall delays later operations
+// without showing up in their latency.
+//
+// Open loop (--open-loop <ops/s>): operations are scheduled at the target
+// rate up front and latency runs from each one's intended start, so time
+// spent queued behind a slow operation counts, as it would for a client.
+// Gaps are constant, Poisson, or the workload's own bursty gaps rescaled
+// to the rate (--arrival). --sweep <from>:<to> repeats the open-loop run
+// on a fresh book at rates growing by 25% and reports the highest rate
+// whose p99 stays within --slo-us (default: twice the p99 at the lowest
+// rate).
+//
+// --perf reads hardware counters (perf_counters.hpp) around a closed-loop
+// run and reports them per operation in one BENCH_PERF line, so a change to
+// the book can be judged by cache misses per op as well as by time. The
+// counts include the loop's own timing and recording, a constant few dozen
+// instructions per op.
+struct BenchOptions {
+    std::size_t n = 0;
+    std::string workload = "uniform";
+    std::string hist_out;
+    double      rate = 0;            // ops/s; 0 = closed loop
+    std::string arrival = "poisson"; // constant | poisson | workload
+    double      sweep_from = 0, sweep_to = 0;
+    double      slo_us = 0;          // 0 = 2x the p99 at the lowest swept rate
+    bool        perf = false;
+};
+
+struct BenchRun {
+    LatencyHistogram add, cancel, market;
+    std::size_t trades = 0, cancel_ok = 0, cancel_miss = 0;
+    double      seconds = 0;
+
+    // Runs `c` and records the time since `t_start` (ticks).
+    void execute(OrderBook& ob, const Command& c, std::uint64_t t_start) {
+        switch (c.type) {
+        case CommandType::Add: {
+            trades += ob.add_limit(c.id, c.side, c.price, c.qty).size();
+            add.record(CycleClock::now() - t_start);
+            break;
         }
+        case CommandType::Cancel: {
+            const bool ok = ob.cancel(c.id);
+            cancel.record(CycleClock::now() - t_start);
+            if (ok) ++cancel_ok; else ++cancel_miss;
+            break;
+        }
+        default: {
+            trades += ob.add_market(c.id, c.side, c.qty).size();
+            market.record(CycleClock::now() - t_start);
+            break;
+        }
+        }
+    }
+
+    [[nodiscard]] LatencyHistogram all() const {
+        LatencyHistogram h;
+        h.merge(add); h.merge(cancel); h.merge(market);
+        return h;
+    }
+};
+
+static void print_latency(const char* op, const LatencyHistogram& h) {
+    auto ns = [](std::uint64_t ticks) { return CycleClock::to_ns(ticks); };
+    std::cout << "BENCH_LAT op=" << op << " count=" << h.count()
+              << " p50_ns=" << ns(h.percentile(50)) << " p90_ns=" << ns(h.percentile(90))
+              << " p99_ns=" << ns(h.percentile(99)) << " p99.9_ns=" << ns(h.percentile(99.9))
+              << " p99.99_ns=" << ns(h.percentile(99.99)) << " max_ns=" << ns(h.max()) << "\n";
+}
+
+static void write_histogram(const std::string& path, const LatencyHistogram& h) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("cannot write " + path);
+    h.write_percentiles(out, 1000.0 / CycleClock::ns_per_tick());  // values in us
+}
+
+static BenchRun run_closed_loop(const std::vector<WorkloadOp>& ops, PerfCounters* perf = nullptr) {
+    OrderBook ob;
+    BenchRun run;
+    if (perf) perf->start();
+    const auto start = std::chrono::steady_clock::now();
+    for (const WorkloadOp& op : ops) run.execute(ob, op.cmd, CycleClock::now());
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (perf) perf->stop();
+    return run;
+}
+
+// Intended start of every operation, in ticks from the start of the run.
+static std::vector<std::uint64_t> schedule(const std::vector<WorkloadOp>& ops, double rate,
+                                           const std::string& arrival, std::uint64_t seed) {
+    const double mean_ns = 1e9 / rate;
+    double workload_mean = 0;
+    for (const auto& op : ops) workload_mean += static_cast<double>(op.gap_ns);
+    workload_mean /= static_cast<double>(std::max<std::size_t>(ops.size(), 1));
+
+    std::mt19937_64 rng(seed);
+    std::exponential_distribution<double> poisson(1.0 / mean_ns);
+    std::vector<std::uint64_t> at(ops.size());
+    double t_ns = 0;
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        at[i] = static_cast<std::uint64_t>(t_ns / CycleClock::ns_per_tick());
+        if      (arrival == "constant") t_ns += mean_ns;
+        else if (arrival == "poisson")  t_ns += poisson(rng);
+        else if (arrival == "workload") t_ns += workload_mean > 0 ? static_cast<double>(ops[i].gap_ns) * mean_ns / workload_mean : mean_ns;
+        else throw std::invalid_argument("Unknown arrival process: " + arrival);
     }
-    auto end = std::chrono::steady_clock::now();
-    std::chrono::duration<double> sec = end-start;
-    double p50=0, p95=0;
-    if (!lat_us.empty()) {
-        std::sort(lat_us.begin(), lat_us.end());
-        p50 = lat_us[static_cast<std::size_t>(0.50*(lat_us.size()-1))];
-        p95 = lat_us[static_cast<std::size_t>(0.95*(lat_us.size()-1))];
-    }
-    std::cout << "BENCH_MIX ops=" << n << " adds=" << adds << " cancels=" << cancels
-              << " markets=" << markets << " trades=" << trades_count
-              << " cancel_ok=" << cancel_ok << " cancel_miss=" << cancel_miss
-              << " seconds=" << sec.count() << " ops_per_sec=" << n/sec.count()
-              << " p50_us=" << p50 << " p95_us=" << p95 << "\n";
+    return at;
+}
+
+static BenchRun run_open_loop(const std::vector<WorkloadOp>& ops, const std::vector<std::uint64_t>& at) {
+    OrderBook ob;
+    BenchRun run;
+    const std::uint64_t base = CycleClock::now();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        const std::uint64_t due = base + at[i];
+        while (CycleClock::now() < due) {}  // early: wait for the intended time
+        run.execute(ob, ops[i].cmd, due);    // late: the backlog counts as latency
+    }
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return run;
+}
+
+static void print_run(const BenchOptions& o, const BenchRun& run, std::size_t n) {
+    const LatencyHistogram all = run.all();
+    auto us = [](std::uint64_t ticks) { return static_cast<double>(CycleClock::to_ns(ticks)) / 1000.0; };
+    std::cout << "BENCH_MIX workload=" << o.workload << " ops=" << n << " adds=" << run.add.count()
+              << " cancels=" << run.cancel.count() << " markets=" << run.market.count()
+              << " trades=" << run.trades << " cancel_ok=" << run.cancel_ok << " cancel_miss=" << run.cancel_miss
+              << " seconds=" << run.seconds << " ops_per_sec=" << static_cast<double>(n) / run.seconds
+              << " p50_us=" << us(all.percentile(50)) << " p95_us=" << us(all.percentile(95));
+    if (o.rate > 0) std::cout << " target_ops_per_sec=" << o.rate << " arrival=" << o.arrival;
+    std::cout << "\n";
+    print_latency("add", run.add);
+    print_latency("cancel", run.cancel);
+    print_latency("market", run.market);
+    print_latency("all", all);
+
+    if (!o.hist_out.empty()) {
+        write_histogram(o.hist_out + ".add.hgrm", run.add);
+        write_histogram(o.hist_out + ".cancel.hgrm", run.cancel);
+        write_histogram(o.hist_out + ".market.hgrm", run.market);
+        write_histogram(o.hist_out + ".all.hgrm", all);
+    }
+}
+
+static void print_perf(const PerfCounters& pc, std::size_t n) {
+    if (!pc.available()) {
+        std::cout << "BENCH_PERF unavailable reason=\"" << pc.error() << "\"\n";
+        return;
+    }
+    const PerfCounters::Counts c = pc.read();
+    const double ops = static_cast<double>(std::max<std::size_t>(n, 1));
+    std::cout << "BENCH_PERF ops=" << n;
+    for (std::size_t e = 0; e < PerfCounters::kEvents; ++e) {
+        const auto ev = static_cast<PerfCounters::Event>(e);
+        std::cout << " " << PerfCounters::name(ev) << "_per_op=";
+        if (pc.available(ev)) std::cout << static_cast<double>(c[e]) / ops;
+        else                  std::cout << "n/a";
+    }
+    if (c[PerfCounters::Cycles] > 0 && pc.available(PerfCounters::Instructions))
+        std::cout << " ipc=" << static_cast<double>(c[PerfCounters::Instructions]) / static_cast<double>(c[PerfCounters::Cycles]);
+    std::cout << "\n";
+}
+
+static int run_sweep(const BenchOptions& o, const std::vector<WorkloadOp>& ops, std::uint64_t seed) {
+    (void)run_closed_loop(ops);  // warm-up: the first run pays page faults and allocator growth
+    double slo_ns = o.slo_us * 1000.0;
+    double knee = 0;
+    int misses = 0;
+    for (double rate = o.sweep_from; rate <= o.sweep_to * 1.0001 && misses < 2; rate *= 1.25) {
+        const BenchRun run = run_open_loop(ops, schedule(ops, rate, o.arrival, seed));
+        const LatencyHistogram all = run.all();
+        const auto p99 = static_cast<double>(CycleClock::to_ns(all.percentile(99)));
+        if (slo_ns == 0) slo_ns = 2 * p99;
+        const bool ok = p99 <= slo_ns;
+        if (ok) { knee = rate; misses = 0; } else { ++misses; }
+        std::cout << "SWEEP rate=" << static_cast<std::uint64_t>(rate)
+                  << " achieved=" << static_cast<std::uint64_t>(static_cast<double>(ops.size()) / run.seconds)
+                  << " p50_ns=" << CycleClock::to_ns(all.percentile(50)) << " p99_ns=" << static_cast<std::uint64_t>(p99)
+                  << " p99.9_ns=" << CycleClock::to_ns(all.percentile(99.9))
+                  << " max_ns=" << CycleClock::to_ns(all.max()) << (ok ? "" : " DEGRADED") << "\n";
+    }
+    std::cout << "SWEEP_RESULT workload=" << o.workload << " arrival=" << o.arrival
+              << " p99_slo_ns=" << static_cast<std::uint64_t>(slo_ns)
+              << " max_rate=" << static_cast<std::uint64_t>(knee) << "\n";
+    return 0;
+}
+
+static int run_bench(const BenchOptions& o) {
+    const WorkloadConfig cfg = resolve_workload(o.workload);
+    // Generated up front so the timed loop only runs the book.
+    const std::vector<WorkloadOp> ops = WorkloadGenerator(cfg).generate(o.n);
+    (void)CycleClock::ns_per_tick();  // calibrate outside the timed loop
+
+    if (o.perf && (o.rate > 0 || o.sweep_to > 0))
+        throw std::invalid_argument("--perf needs a closed-loop run (the open loop spins between ops)");
+    if (o.sweep_to > 0) return run_sweep(o, ops, cfg.seed);
+
+    std::unique_ptr<PerfCounters> perf;
+    if (o.perf) perf = std::make_unique<PerfCounters>();
+    const BenchRun run = o.rate > 0 ? run_open_loop(ops, schedule(ops, o.rate, o.arrival, cfg.seed))
+                                    : run_closed_loop(ops, perf.get());
+    print_run(o, run, ops.size());
+    if (perf) print_perf(*perf, ops.size());
     return 0;
 }
 
@@ -176,11 +980,13 @@ static int run_file(const char* path) {
             if (cmd == "ADD") {
                 OrderId id; std::string side_s; std::int64_t price, qty;
                 ss >> id >> side_s >> price >> qty;
-                print_trades(ob.add_limit(id, parse_side(side_s), price, qty));
+                const Command c = with_options(Command{ id, price, qty, CommandType::Add, parse_side(side_s), {} }, ss);
+                print_trades(std::cout, apply_command(ob, c));
             } else if (cmd == "MARKET") {
                 OrderId id; std::string side_s; std::int64_t qty;
                 ss >> id >> side_s >> qty;
-                print_trades(ob.add_market(id, parse_side(side_s), qty));
+                const Command c = with_options(Command{ id, 0, qty, CommandType::Market, parse_side(side_s), {} }, ss);
+                print_trades(std::cout, apply_command(ob, c));
             } else if (cmd == "CANCEL") {
                 OrderId id; ss >> id;
                 std::cout << "CANCEL id=" << id << " " << (ob.cancel(id)?"OK":"NOT_FOUND") << "\n";
@@ -194,14 +1000,160 @@ static int run_file(const char* path) {
     return 0;
 }
 
+// ── Depth query on a mapped snapshot ──────────────────────────────────────────
+// Opens a --mapped-snapshot file in place and prints the top `n` levels per
+// side, without building an OrderBook.
+static int run_depth(const std::string& path, std::size_t n) {
+    const MappedBook book(path);
+    std::cout << "SNAPSHOT lsn=" << book.lsn() << " orders=" << book.orders().size() << "\n";
+    auto print = [&](const char* side, std::span<const MappedLevel> levels) {
+        for (const auto& lvl : levels.first(std::min(n, levels.size())))
+            std::cout << side << " price=" << lvl.price << " qty=" << lvl.total_qty
+                      << " orders=" << lvl.count << "\n";
+    };
+    print("BID", book.bids());
+    print("ASK", book.asks());
+    return 0;
+}
+
+// ── Parallel replay ───────────────────────────────────────────────────────────
+// Replays each file of a directory (text commands or journals) into its own
+// book on a thread pool and prints one digest line per file, sorted by path,
+// so two runs can be compared with diff. Exits 2 if any file failed.
+static int run_replay(const std::string& path, unsigned threads) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto results = replay_paths(path, threads);
+    std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+
+    bool failed = false;
+    char digests[64];
+    for (const auto& r : results) {
+        std::snprintf(digests, sizeof digests, "trade_digest=%016llx book_digest=%016llx",
+                      static_cast<unsigned long long>(r.trade_digest),
+                      static_cast<unsigned long long>(r.book_digest));
+        std::cout << "REPLAY file=" << r.path << " commands=" << r.commands
+                  << " trades=" << r.trades << " " << digests;
+        if (!r.error.empty()) { std::cout << " ERROR " << r.error; failed = true; }
+        std::cout << "\n";
+    }
+    std::cerr << "Replayed " << results.size() << " files in " << sec.count() << " s\n";
+    return failed ? 2 : 0;
+}
+
 // ── Entry point ───────────────────────────────────────────────────────────────
-int main(int argc, char** argv) {
-    if (argc == 1)                                      return run_interactive();
-    if (argc == 3 && std::string(argv[1]) == "--bench") return run_bench(std::stoull(argv[2]));
-    if (argc == 2)                                      return run_file(argv[1]);
+static Durability parse_durability(const std::string& s) {
+    if (s == "none")  return Durability::None;
+    if (s == "async") return Durability::Async;
+    if (s == "sync")  return Durability::Sync;
+    throw std::invalid_argument("Invalid durability: " + s + " (none|async|sync)");
+}
+
+static int usage(const char* argv0) {
     std::cerr << "Usage:\n"
-              << "  " << argv[0] << "                 # interactive mode (FastAPI bridge)\n"
-              << "  " << argv[0] << " <file>          # file replay\n"
-              << "  " << argv[0] << " --bench <N>     # benchmark\n";
+              << "  " << argv0 << " [engine options]             # interactive mode (FastAPI bridge)\n"
+              << "  " << argv0 << " --shm <name> [engine options] # shared-memory transport (/dev/shm/<name>)\n"
+              << "  " << argv0 << " --follow <socket> [options]  # hot standby; interactive once promoted\n"
+              << "  " << argv0 << " <file>                       # file replay\n"
+              << "  " << argv0 << " --bench <N> [bench options]  # benchmark\n"
+              << "  " << argv0 << " --depth <mapped> [N]         # top N levels of a mapped snapshot\n"
+              << "  " << argv0 << " --replay <dir|file> [threads] # parallel replay with per-book digests\n"
+              << "Bench options:\n"
+              << "  --workload <preset|file>  uniform (default) | equity | futures | config file\n"
+              << "  --hist-out <prefix>       write latency distributions to <prefix>.<op>.hgrm\n"
+              << "  --open-loop <ops/s>       schedule ops at this rate; latency from intended start\n"
+              << "  --arrival <process>       poisson (default) | constant | workload (open loop)\n"
+              << "  --sweep <from>:<to>       open-loop rates from..to (x1.25 steps); report max rate\n"
+              << "  --slo-us <us>             p99 limit for --sweep (default 2x p99 at the lowest rate)\n"
+              << "  --perf                    report hardware counters per op (closed loop, Linux)\n"
+              << "Engine options:\n"
+              << "  --journal <path>          append accepted commands; replayed on startup\n"
+              << "  --durability <mode>       none | async (default) | sync\n"
+              << "  --group-commit <N>        commit after N pending records (default 4096)\n"
+              << "  --group-commit-us <us>    ... or once the oldest is this old (default 500)\n"
+              << "  --snapshot <path>         restore from this snapshot on startup; SNAPSHOT writes it\n"
+              << "  --snapshot-every <N>      also write it every N accepted commands\n"
+              << "  --mapped-snapshot <path>  also write an mmap-able copy (see --depth)\n"
+              << "  --replicate <socket>      stream accepted commands to --follow engines\n"
+              << "  --slowlog-us <us>         SLOWLOG keeps book calls slower than this (default 100)\n"
+              << "  --slowlog-len <N>         ... the newest N of them (default 128, 0 = off)\n"
+              << "  --risk <path>             check ADD / MARKET against per-account limits (see RISK)\n"
+              << "  --trace-out <path>        TRACE / SIGUSR2 dump target (default lob-<pid>.trace; LOB_TRACE builds)\n";
     return 1;
 }
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && std::string(argv[1]) == "--bench") {
+        try {
+            BenchOptions bo;
+            bo.n = std::stoull(argv[2]);
+            for (int i = 3; i < argc; ++i) {
+                const std::string arg = argv[i];
+                if (arg == "--perf") { bo.perf = true; continue; }
+                if (i + 1 >= argc) return usage(argv[0]);
+                const std::string val = argv[++i];
+                if      (arg == "--workload")  bo.workload = val;
+                else if (arg == "--hist-out")  bo.hist_out = val;
+                else if (arg == "--open-loop") bo.rate = std::stod(val);
+                else if (arg == "--arrival")   bo.arrival = val;
+                else if (arg == "--slo-us")    bo.slo_us = std::stod(val);
+                else if (arg == "--sweep") {
+                    const auto colon = val.find(':');
+                    if (colon == std::string::npos) throw std::invalid_argument("--sweep takes <from>:<to>");
+                    bo.sweep_from = std::stod(val.substr(0, colon));
+                    bo.sweep_to   = std::stod(val.substr(colon + 1));
+                    if (bo.sweep_from <= 0 || bo.sweep_to < bo.sweep_from) throw std::invalid_argument("--sweep needs 0 < from <= to");
+                }
+                else return usage(argv[0]);
+            }
+            return run_bench(bo);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (argc == 2 && argv[1][0] != '-')                 return run_file(argv[1]);
+    if ((argc == 3 || argc == 4) && (std::string(argv[1]) == "--depth" || std::string(argv[1]) == "--replay")) {
+        try {
+            if (std::string(argv[1]) == "--replay")
+                return run_replay(argv[2], argc == 4 ? static_cast<unsigned>(std::stoul(argv[3])) : 0);
+            return run_depth(argv[2], argc == 4 ? std::stoull(argv[3]) : 10);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    EngineOptions opts;
+    std::string shm_name, follow_path;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) return usage(argv[0]);
+            const std::string val = argv[++i];
+            if      (arg == "--shm")             shm_name = val;
+            else if (arg == "--follow")          follow_path = val;
+            else if (arg == "--replicate")       opts.replicate_path = val;
+            else if (arg == "--journal")         opts.journal_path = val;
+            else if (arg == "--durability")      opts.journal.durability = parse_durability(val);
+            else if (arg == "--group-commit")    opts.journal.batch_records = std::stoull(val);
+            else if (arg == "--group-commit-us") opts.journal.batch_interval = std::chrono::microseconds(std::stoll(val));
+            else if (arg == "--snapshot")        opts.snapshot_path = val;
+            else if (arg == "--snapshot-every")  opts.snapshot_every = std::stoull(val);
+            else if (arg == "--mapped-snapshot") opts.mapped_snapshot_path = val;
+            else if (arg == "--trace-out")       opts.trace_path = val;
+            else if (arg == "--slowlog-us")      opts.slowlog_us = std::stoull(val);
+            else if (arg == "--slowlog-len")     opts.slowlog_len = std::stoull(val);
+            else if (arg == "--risk")            opts.risk_path = val;
+            else return usage(argv[0]);
+        }
+        if (opts.trace_path.empty()) opts.trace_path = "lob-" + std::to_string(::getpid()) + ".trace";
+        if (trace_enabled()) trace_dump_on_signal(SIGUSR2, opts.trace_path);
+        if (!shm_name.empty())    return run_shm(shm_name, opts);
+        if (!follow_path.empty()) return run_follower(follow_path, opts);
+        OrderBook ob;
+        return run_interactive(opts, ob);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
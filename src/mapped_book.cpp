@@ -0,0 +1,202 @@
+#include "mapped_book.hpp"
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ── Layout (see mapped_book.hpp) ──────────────────────────────────────────────
+
+namespace {
+
+constexpr char          kMagic[8] = { 'L', 'O', 'B', 'M', 'A', 'P', '0', '1' };
+constexpr std::uint32_t kVersion  = 3;
+
+struct Header {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t order_record_size;
+    std::uint32_t level_record_size;
+    std::uint32_t reserved;
+    std::uint64_t lsn;
+    std::uint64_t next_seq;
+    std::uint64_t bid_levels;
+    std::uint64_t ask_levels;
+    std::uint64_t order_count;
+    std::uint64_t trade_hash;
+    std::uint64_t trade_count;
+    std::uint64_t event_seq;
+};
+static_assert(sizeof(Header) == 88);
+
+const Header& header_of(const std::byte* base) { return *reinterpret_cast<const Header*>(base); }
+
+template <typename T>
+void put(std::ostream& out, const T* data, std::size_t n) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(n * sizeof(T)));
+}
+
+}  // namespace
+
+// ── Writing ───────────────────────────────────────────────────────────────────
+
+void write_mapped_snapshot(std::ostream& out, const BookImage& image) {
+    const auto& src = image.orders;
+
+    // Image orders are already in priority order, bids then asks: a level is
+    // a run of equal (side, price).
+    std::vector<MappedLevel> levels;
+    std::uint64_t bid_levels = 0;
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        const Order& o = src[i];
+        if (i == 0 || o.side != src[i - 1].side || o.price != src[i - 1].price) {
+            levels.push_back(MappedLevel{ o.price, 0, i, 0 });
+            if (o.side == Side::Buy) ++bid_levels;
+        }
+        levels.back().total_qty += o.qty;
+        ++levels.back().count;
+    }
+
+    std::vector<std::uint64_t> by_id(src.size());
+    std::iota(by_id.begin(), by_id.end(), std::uint64_t{0});
+    std::sort(by_id.begin(), by_id.end(), [&](auto a, auto b) { return src[a].id < src[b].id; });
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version           = kVersion;
+    h.order_record_size = sizeof(MappedOrder);
+    h.level_record_size = sizeof(MappedLevel);
+    h.lsn               = image.lsn;
+    h.next_seq          = image.next_seq;
+    h.bid_levels        = bid_levels;
+    h.ask_levels        = levels.size() - bid_levels;
+    h.order_count       = src.size();
+    h.trade_hash        = image.trade_hash;
+    h.trade_count       = image.trade_count;
+    h.event_seq         = image.event_seq;
+    put(out, &h, 1);
+    put(out, levels.data(), levels.size());
+
+    for (const Order& o : src) {
+        MappedOrder r{};
+        r.id = o.id; r.price = o.price; r.qty = o.qty; r.seq = o.seq; r.side = o.side; r.owner = o.owner;
+        put(out, &r, 1);
+    }
+    put(out, by_id.data(), by_id.size());
+    if (!out) throw std::runtime_error("mapped snapshot write failed");
+}
+
+void write_mapped_snapshot_file(const std::string& path, const BookImage& image) {
+    write_file_durably(path, [&](std::ostream& out) { write_mapped_snapshot(out, image); });
+}
+
+// ── Reading ───────────────────────────────────────────────────────────────────
+
+MappedBook::MappedBook(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::system_error(errno, std::generic_category(), "fstat " + path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ < sizeof(Header)) { ::close(fd); throw std::runtime_error("not a mapped snapshot (too small): " + path); }
+
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap " + path);
+    base_ = static_cast<const std::byte*>(p);
+
+    // The section sizes come from the file: a count crafted to wrap the
+    // arithmetic around to the file size must not pass the check.
+    const Header& h = header_of(base_);
+    std::uint64_t levels = 0, level_bytes = 0, order_bytes = 0, expect = sizeof(Header);
+    const bool overflow =
+        __builtin_add_overflow(h.bid_levels, h.ask_levels, &levels) ||
+        __builtin_mul_overflow(levels, sizeof(MappedLevel), &level_bytes) ||
+        __builtin_mul_overflow(h.order_count, sizeof(MappedOrder) + sizeof(std::uint64_t), &order_bytes) ||
+        __builtin_add_overflow(expect, level_bytes, &expect) ||
+        __builtin_add_overflow(expect, order_bytes, &expect);
+    if (overflow || std::memcmp(h.magic, kMagic, sizeof kMagic) != 0 || h.version != kVersion ||
+        h.order_record_size != sizeof(MappedOrder) || h.level_record_size != sizeof(MappedLevel) ||
+        levels > h.order_count || expect != size_) {
+        ::munmap(const_cast<std::byte*>(base_), size_);
+        throw std::runtime_error("not a mapped snapshot (bad header): " + path);
+    }
+
+    const auto* lv = reinterpret_cast<const MappedLevel*>(base_ + sizeof(Header));
+    const auto* od = reinterpret_cast<const MappedOrder*>(lv + levels);
+    bids_   = { lv, static_cast<std::size_t>(h.bid_levels) };
+    asks_   = { lv + h.bid_levels, static_cast<std::size_t>(h.ask_levels) };
+    orders_ = { od, static_cast<std::size_t>(h.order_count) };
+    by_id_  = { reinterpret_cast<const std::uint64_t*>(od + h.order_count), static_cast<std::size_t>(h.order_count) };
+
+    // Level links are checked up front (there are few of them), so orders()
+    // can hand out spans without bounds checks.
+    for (std::uint64_t i = 0; i < levels; ++i) {
+        if (lv[i].first > h.order_count || lv[i].count > h.order_count - lv[i].first) {
+            ::munmap(const_cast<std::byte*>(base_), size_);
+            throw std::runtime_error("not a mapped snapshot (bad level link): " + path);
+        }
+    }
+}
+
+MappedBook::MappedBook(MappedBook&& other) noexcept
+    : base_(other.base_), size_(other.size_),
+      bids_(other.bids_), asks_(other.asks_), orders_(other.orders_), by_id_(other.by_id_) {
+    other.base_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedBook::~MappedBook() {
+    if (base_) ::munmap(const_cast<std::byte*>(base_), size_);
+}
+
+std::uint64_t MappedBook::lsn() const      { return header_of(base_).lsn; }
+std::uint64_t MappedBook::next_seq() const { return header_of(base_).next_seq; }
+
+std::span<const MappedOrder> MappedBook::orders(const MappedLevel& level) const {
+    return orders_.subspan(level.first, level.count);
+}
+
+std::optional<std::int64_t> MappedBook::best_bid() const {
+    if (bids_.empty()) return std::nullopt;
+    return bids_.front().price;
+}
+
+std::optional<std::int64_t> MappedBook::best_ask() const {
+    if (asks_.empty()) return std::nullopt;
+    return asks_.front().price;
+}
+
+const MappedOrder* MappedBook::find(OrderId id) const {
+    auto it = std::lower_bound(by_id_.begin(), by_id_.end(), id, [&](std::uint64_t pos, OrderId key) {
+        return pos < orders_.size() && orders_[pos].id < key;
+    });
+    if (it == by_id_.end() || *it >= orders_.size() || orders_[*it].id != id) return nullptr;
+    return &orders_[*it];
+}
+
+BookImage MappedBook::image() const {
+    const Header& h = header_of(base_);
+    BookImage img;
+    img.lsn         = h.lsn;
+    img.next_seq    = h.next_seq;
+    img.trade_hash  = h.trade_hash;
+    img.trade_count = h.trade_count;
+    img.event_seq   = h.event_seq;
+    img.orders.reserve(orders_.size());
+    for (const MappedOrder& r : orders_) img.orders.push_back(Order{ r.id, r.side, r.owner, r.price, r.qty, r.seq });
+    return img;
+}
@@ -1,8 +1,84 @@
 #include "order_book.hpp"
+#include "snapshot.hpp"
+#include "trace.hpp"
 
 #include <mutex>
 #include <stdexcept>
 
+// ── Hashing ───────────────────────────────────────────────────────────────────
+
+namespace {
+
+// splitmix64 finaliser: cheap, and every input bit affects every output bit.
+std::uint64_t mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Contribution of one resting order to BookHash::state. The state hash is a
+// wrapping sum, so an order is removed by subtracting what it added. The
+// owner only enters when set, so anonymous orders hash as they always have.
+std::uint64_t order_hash(const Order& o) {
+    std::uint64_t h = mix(o.id);
+    if (o.owner) h = mix(h ^ (std::uint64_t{ o.owner } << 32));
+    h = mix(h ^ static_cast<std::uint64_t>(o.price));
+    h = mix(h ^ static_cast<std::uint64_t>(o.qty));
+    return mix(h ^ (o.seq << 1 | static_cast<std::uint64_t>(o.side)));
+}
+
+}  // namespace
+
+void OrderBook::add_trade_hash(const Trade& t) {
+    std::uint64_t h = mix(hash_.trades ^ static_cast<std::uint64_t>(t.price));
+    h = mix(h ^ static_cast<std::uint64_t>(t.qty));
+    h = mix(h ^ t.buy_id);
+    hash_.trades = mix(h ^ t.sell_id);
+    ++hash_.trade_count;
+}
+
+// The trades of a level are consecutive and share its price.
+std::uint32_t levels_touched(const std::vector<Trade>& trades) {
+    std::uint32_t n = 0;
+    for (std::size_t i = 0; i < trades.size(); ++i)
+        if (i == 0 || trades[i].price != trades[i - 1].price) ++n;
+    return n;
+}
+
+// ── Counters ──────────────────────────────────────────────────────────────────
+
+namespace {
+
+// Counters only change under the exclusive lock, so a relaxed load and store
+// is a correct increment and avoids a locked read-modify-write.
+void bump(std::atomic<std::uint64_t>& c, std::uint64_t n = 1) {
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+void OrderBook::reject(const char* why, [[maybe_unused]] TraceOp op, [[maybe_unused]] OrderId id) {
+    LOB_TRACE_REJECT(op, id);
+    bump(counters_.rejected);
+    throw std::invalid_argument(why);
+}
+
+void OrderBook::note_shape() {
+    const std::uint64_t levels = bids_.size() + asks_.size();
+    counters_.levels.store(levels, std::memory_order_relaxed);
+    counters_.resting.store(index_.size(), std::memory_order_relaxed);
+    if (levels > counters_.peak_levels.load(std::memory_order_relaxed))
+        counters_.peak_levels.store(levels, std::memory_order_relaxed);
+}
+
+BookStats OrderBook::stats() const {
+    auto get = [](const std::atomic<std::uint64_t>& c) { return c.load(std::memory_order_relaxed); };
+    return BookStats{ get(counters_.added), get(counters_.cancelled), get(counters_.filled),
+                      get(counters_.trades), get(counters_.rejected), get(counters_.levels),
+                      get(counters_.resting), get(counters_.peak_levels), get(counters_.prevented) };
+}
+
 // ── Constructor ───────────────────────────────────────────────────────────────
 
 OrderBook::OrderBook() : next_seq_(1) {}
@@ -21,78 +97,203 @@ std::optional<std::int64_t> OrderBook::best_ask() const {
     return asks_.begin()->first;
 }
 
+Touch OrderBook::touch() const {
+    std::shared_lock lock(mtx_);
+    Touch t;
+    if (!bids_.empty()) t.bid = bids_.begin()->first;
+    if (!asks_.empty()) t.ask = asks_.begin()->first;
+    return t;
+}
+
 bool OrderBook::empty() const {
     std::shared_lock lock(mtx_);
     return bids_.empty() && asks_.empty();
 }
 
+BookHash OrderBook::hash() const {
+    std::shared_lock lock(mtx_);
+    return hash_;
+}
+
+BookDepth OrderBook::depth(std::size_t levels) const {
+    std::shared_lock lock(mtx_);
+    BookDepth d;
+    d.bids.reserve(std::min(levels, bids_.size()));
+    d.asks.reserve(std::min(levels, asks_.size()));
+    for (auto it = bids_.begin(); it != bids_.end() && d.bids.size() < levels; ++it)
+        d.bids.push_back(DepthLevel{ it->first, it->second.total_qty, it->second.count });
+    for (auto it = asks_.begin(); it != asks_.end() && d.asks.size() < levels; ++it)
+        d.asks.push_back(DepthLevel{ it->first, it->second.total_qty, it->second.count });
+    return d;
+}
+
+// ── Market data ───────────────────────────────────────────────────────────────
+
+void OrderBook::set_listener(BookListener* listener) {
+    std::unique_lock lock(mtx_);
+    listener_ = listener;
+}
+
+void OrderBook::report_level(Side side, std::int64_t price, const Level* lvl) {
+    if (!listener_) return;
+    listener_->on_level(LevelUpdate{ side, DepthLevel{ price, lvl ? lvl->total_qty : 0, lvl ? lvl->count : 0u } });
+}
+
+// `o` is the order after the event (remaining qty already updated).
+void OrderBook::report_order(OrderEventType type, const Order& o, std::int64_t qty,
+                             OrderId contra, AccountId contra_owner) {
+    ++event_seq_;
+    if (!listener_) return;
+    listener_->on_order(OrderEvent{ event_seq_, type, o.side, o.owner, o.id, o.price, qty,
+                                    type == OrderEventType::Cancel ? 0 : o.qty, o.seq, contra, contra_owner });
+}
+
+// ── Snapshot / restore ────────────────────────────────────────────────────────
+
+BookImage OrderBook::capture() const {
+    std::shared_lock lock(mtx_);
+    BookImage img;
+    img.next_seq    = next_seq_.load(std::memory_order_relaxed);
+    img.trade_hash  = hash_.trades;
+    img.trade_count = hash_.trade_count;
+    img.event_seq   = event_seq_;
+    img.orders.reserve(index_.size());
+    for (const auto& [price, lvl] : bids_) img.orders.insert(img.orders.end(), lvl.q.begin(), lvl.q.end());
+    for (const auto& [price, lvl] : asks_) img.orders.insert(img.orders.end(), lvl.q.begin(), lvl.q.end());
+    return img;
+}
+
+void OrderBook::restore(const BookImage& image) {
+    std::unique_lock lock(mtx_);
+    bids_.clear();
+    asks_.clear();
+    index_.clear();
+    index_.reserve(image.orders.size());
+    hash_      = BookHash{ 0, image.trade_hash, image.trade_count };
+    event_seq_ = image.event_seq;
+
+    // Orders arrive in priority order, so appending preserves FIFO per level.
+    for (const Order& o : image.orders) {
+        if (index_.count(o.id)) throw std::invalid_argument("duplicate order id in image");
+        Level& lvl = (o.side == Side::Buy) ? bids_[o.price] : asks_[o.price];
+        auto& lst = lvl.q;
+        lst.push_back(o);
+        lvl.total_qty += o.qty;
+        ++lvl.count;
+        index_[o.id] = Locator{ o.side, o.price, std::prev(lst.end()) };
+        hash_.state += order_hash(o);
+    }
+    next_seq_.store(image.next_seq, std::memory_order_relaxed);
+    note_shape();
+}
+
+void OrderBook::snapshot(std::ostream& out) const {
+    write_snapshot(out, capture());
+}
+
+void OrderBook::restore(std::istream& in) {
+    restore(read_snapshot(in));
+}
+
 // ── Mutating operations (exclusive lock) ─────────────────────────────────────
 
 std::vector<Trade> OrderBook::add_limit(OrderId id, Side side,
-                                        std::int64_t price, std::int64_t qty) {
-    if (qty   <= 0) throw std::invalid_argument("qty must be > 0");
-    if (price <= 0) throw std::invalid_argument("price must be > 0");
-
+                                        std::int64_t price, std::int64_t qty,
+                                        AccountId owner, StpMode stp) {
+    LOB_TRACE_BEGIN(TraceOp::AddLimit, id);
     std::unique_lock lock(mtx_);
 
-    if (index_.count(id)) throw std::invalid_argument("duplicate order id");
+    if (qty   <= 0)       reject("qty must be > 0", TraceOp::AddLimit, id);
+    if (price <= 0)       reject("price must be > 0", TraceOp::AddLimit, id);
+    if (index_.count(id)) reject("duplicate order id", TraceOp::AddLimit, id);
 
     // fetch_add returns old value; post-increment gives unique seq per order
-    Order incoming{ id, side, price, qty, next_seq_.fetch_add(1, std::memory_order_relaxed) };
+    Order incoming{ id, side, owner, price, qty, next_seq_.fetch_add(1, std::memory_order_relaxed) };
 
-    auto trades = match_incoming(incoming);
+    const std::size_t resting_before = index_.size();
+    auto trades = match_incoming(incoming, stp);
+    bump(counters_.added);
+    bump(counters_.trades, trades.size());
+    bump(counters_.filled, resting_before - index_.size() - stp_removed_);
 
     if (incoming.qty > 0) {
-        if (side == Side::Buy) {
-            auto& lst = bids_[price].q;
-            lst.push_back(incoming);
-            index_[id] = Locator{ side, price, std::prev(lst.end()) };
-        } else {
-            auto& lst = asks_[price].q;
-            lst.push_back(incoming);
-            index_[id] = Locator{ side, price, std::prev(lst.end()) };
-        }
+        hash_.state += order_hash(incoming);
+        Level& lvl = (side == Side::Buy) ? bids_[price] : asks_[price];
+        lvl.q.push_back(incoming);
+        lvl.total_qty += incoming.qty;
+        ++lvl.count;
+        index_[id] = Locator{ side, price, std::prev(lvl.q.end()) };
+        report_order(OrderEventType::Add, incoming, incoming.qty);
+        report_level(side, price, &lvl);
     }
+    note_shape();
 
+    LOB_TRACE_END(TraceOp::AddLimit, id, levels_touched(trades), static_cast<std::uint32_t>(trades.size()));
     return trades;
 }
 
-std::vector<Trade> OrderBook::add_market(OrderId id, Side side, std::int64_t qty) {
-    if (qty <= 0) throw std::invalid_argument("qty must be > 0");
-
+std::vector<Trade> OrderBook::add_market(OrderId id, Side side, std::int64_t qty,
+                                         AccountId owner, StpMode stp) {
+    LOB_TRACE_BEGIN(TraceOp::AddMarket, id);
     std::unique_lock lock(mtx_);
 
-    if (index_.count(id)) throw std::invalid_argument("duplicate order id");
+    if (qty <= 0)         reject("qty must be > 0", TraceOp::AddMarket, id);
+    if (index_.count(id)) reject("duplicate order id", TraceOp::AddMarket, id);
 
     // Market order: price = 0 signals "cross everything"
-    Order incoming{ id, side, 0, qty, next_seq_.fetch_add(1, std::memory_order_relaxed) };
+    Order incoming{ id, side, owner, 0, qty, next_seq_.fetch_add(1, std::memory_order_relaxed) };
 
-    return match_incoming(incoming);
+    const std::size_t resting_before = index_.size();
+    auto trades = match_incoming(incoming, stp);
     // Market orders never rest; unfilled qty is dropped.
+    bump(counters_.added);
+    bump(counters_.trades, trades.size());
+    bump(counters_.filled, resting_before - index_.size() - stp_removed_);
+    note_shape();
+    LOB_TRACE_END(TraceOp::AddMarket, id, levels_touched(trades), static_cast<std::uint32_t>(trades.size()));
+    return trades;
 }
 
 bool OrderBook::cancel(OrderId id) {
+    LOB_TRACE_BEGIN(TraceOp::Cancel, id);
     std::unique_lock lock(mtx_);
 
     auto it = index_.find(id);
-    if (it == index_.end()) return false;
+    if (it == index_.end()) {
+        LOB_TRACE_END(TraceOp::Cancel, id, 0, 0);
+        return false;
+    }
 
     const Locator loc = it->second;
+    hash_.state -= order_hash(*loc.it);
 
     if (loc.side == Side::Buy) {
         auto lvl_it = bids_.find(loc.price);
-        if (lvl_it == bids_.end()) { index_.erase(it); return false; }
-        lvl_it->second.q.erase(loc.it);   // O(1) — iterator still valid
+        if (lvl_it == bids_.end()) { index_.erase(it); LOB_TRACE_END(TraceOp::Cancel, id, 0, 0); return false; }
+        Level& lvl = lvl_it->second;
+        lvl.total_qty -= loc.it->qty;
+        --lvl.count;
+        report_order(OrderEventType::Cancel, *loc.it, loc.it->qty);
+        lvl.q.erase(loc.it);   // O(1) — iterator still valid
         index_.erase(it);
-        if (lvl_it->second.q.empty()) bids_.erase(lvl_it);
+        report_level(loc.side, loc.price, lvl.q.empty() ? nullptr : &lvl);
+        if (lvl.q.empty()) bids_.erase(lvl_it);
     } else {
         auto lvl_it = asks_.find(loc.price);
-        if (lvl_it == asks_.end()) { index_.erase(it); return false; }
-        lvl_it->second.q.erase(loc.it);
+        if (lvl_it == asks_.end()) { index_.erase(it); LOB_TRACE_END(TraceOp::Cancel, id, 0, 0); return false; }
+        Level& lvl = lvl_it->second;
+        lvl.total_qty -= loc.it->qty;
+        --lvl.count;
+        report_order(OrderEventType::Cancel, *loc.it, loc.it->qty);
+        lvl.q.erase(loc.it);
         index_.erase(it);
-        if (lvl_it->second.q.empty()) asks_.erase(lvl_it);
+        report_level(loc.side, loc.price, lvl.q.empty() ? nullptr : &lvl);
+        if (lvl.q.empty()) asks_.erase(lvl_it);
     }
 
+    bump(counters_.cancelled);
+    note_shape();
+    LOB_TRACE_END(TraceOp::Cancel, id, 1, 1);
     return true;
 }
 
@@ -108,14 +309,66 @@ void OrderBook::maybe_erase_empty_level(Side side, std::int64_t price) {
     }
 }
 
+// ── Self-trade prevention ─────────────────────────────────────────────────────
+//
+// Runs in place of a fill when the resting order at the front of the queue
+// has the incoming order's owner. Resting orders it removes are reported as
+// cancels (a decrement that leaves some qty as Reduce); the incoming order's
+// dropped qty is never reported, as it never rested.
+
+void OrderBook::prevent_self_trade(Order& incoming, Level& lvl, std::list<Order>::iterator it, StpMode stp) {
+    Order& resting = *it;
+    ++stp_prevented_;
+
+    std::int64_t removed = 0;  // from the resting order
+    switch (stp) {
+    case StpMode::CancelNewest:
+    default:  // out-of-range modes (apply_command rejects them) must still end the match
+        incoming.qty = 0;
+        return;
+    case StpMode::CancelOldest:
+        removed = resting.qty;
+        break;
+    case StpMode::CancelBoth:
+        removed      = resting.qty;
+        incoming.qty = 0;
+        break;
+    case StpMode::Decrement:
+        removed       = std::min(incoming.qty, resting.qty);
+        incoming.qty -= removed;
+        break;
+    }
+
+    hash_.state   -= order_hash(resting);
+    resting.qty   -= removed;
+    lvl.total_qty -= removed;
+    if (resting.qty > 0) {
+        hash_.state += order_hash(resting);
+        report_order(OrderEventType::Reduce, resting, removed);
+    } else {
+        report_order(OrderEventType::Cancel, resting, removed);
+        --lvl.count;
+        ++stp_removed_;
+        index_.erase(resting.id);
+        lvl.q.erase(it);
+    }
+}
+
 // ── Matching engine (price-time priority FIFO) ────────────────────────────────
 //
 // Consumes `incoming` against the opposite side.
-// Generates Trade records, updates resting order qty, removes fully-filled orders.
+// Generates Trade records, updates resting order qty and level aggregates,
+// removes fully-filled orders, and reports each touched level once. A
+// resting order of the incoming order's owner is handed to
+// prevent_self_trade() instead of being filled: the owners are compared on
+// the order already at hand, so the check costs no lookup.
 // Called exclusively under unique_lock — no additional locking needed here.
 
-std::vector<Trade> OrderBook::match_incoming(Order& incoming) {
+std::vector<Trade> OrderBook::match_incoming(Order& incoming, StpMode stp) {
+    LOB_TRACE_BEGIN(TraceOp::Match, incoming.id);
     std::vector<Trade> trades;
+    stp_prevented_ = 0;
+    stp_removed_   = 0;
 
     const bool is_market = (incoming.price == 0);
 
@@ -127,25 +380,39 @@ std::vector<Trade> OrderBook::match_incoming(Order& incoming) {
 
             if (!is_market && ask_price > incoming.price) break;
 
-            auto& q = lvl_it->second.q;
+            Level& lvl = lvl_it->second;
+            auto&  q   = lvl.q;
 
             while (incoming.qty > 0 && !q.empty()) {
                 auto   it      = q.begin();
                 Order& resting = *it;
 
+                if (incoming.owner != 0 && resting.owner == incoming.owner) {
+                    prevent_self_trade(incoming, lvl, it, stp);
+                    continue;
+                }
+
                 const std::int64_t fill = std::min(incoming.qty, resting.qty);
 
                 trades.push_back(Trade{ ask_price, fill, incoming.id, resting.id });
-
-                incoming.qty -= fill;
-                resting.qty  -= fill;
-
-                if (resting.qty == 0) {
+                add_trade_hash(trades.back());
+
+                hash_.state  -= order_hash(resting);
+                incoming.qty  -= fill;
+                resting.qty   -= fill;
+                lvl.total_qty -= fill;
+                report_order(OrderEventType::Execute, resting, fill, incoming.id, incoming.owner);
+
+                if (resting.qty > 0) {
+                    hash_.state += order_hash(resting);
+                } else {
+                    --lvl.count;
                     index_.erase(resting.id);
                     q.erase(it);
                 }
             }
 
+            report_level(Side::Sell, ask_price, q.empty() ? nullptr : &lvl);
             if (q.empty()) asks_.erase(lvl_it);
         }
     } else {
@@ -156,28 +423,44 @@ std::vector<Trade> OrderBook::match_incoming(Order& incoming) {
 
             if (!is_market && bid_price < incoming.price) break;
 
-            auto& q = lvl_it->second.q;
+            Level& lvl = lvl_it->second;
+            auto&  q   = lvl.q;
 
             while (incoming.qty > 0 && !q.empty()) {
                 auto   it      = q.begin();
                 Order& resting = *it;
 
+                if (incoming.owner != 0 && resting.owner == incoming.owner) {
+                    prevent_self_trade(incoming, lvl, it, stp);
+                    continue;
+                }
+
                 const std::int64_t fill = std::min(incoming.qty, resting.qty);
 
                 trades.push_back(Trade{ bid_price, fill, resting.id, incoming.id });
-
-                incoming.qty -= fill;
-                resting.qty  -= fill;
-
-                if (resting.qty == 0) {
+                add_trade_hash(trades.back());
+
+                hash_.state  -= order_hash(resting);
+                incoming.qty  -= fill;
+                resting.qty   -= fill;
+                lvl.total_qty -= fill;
+                report_order(OrderEventType::Execute, resting, fill, incoming.id, incoming.owner);
+
+                if (resting.qty > 0) {
+                    hash_.state += order_hash(resting);
+                } else {
+                    --lvl.count;
                     index_.erase(resting.id);
                     q.erase(it);
                 }
             }
 
+            report_level(Side::Buy, bid_price, q.empty() ? nullptr : &lvl);
             if (q.empty()) bids_.erase(lvl_it);
         }
     }
 
+    if (stp_prevented_) bump(counters_.prevented, stp_prevented_);
+    LOB_TRACE_END(TraceOp::Match, incoming.id, levels_touched(trades), static_cast<std::uint32_t>(trades.size()));
     return trades;
 }
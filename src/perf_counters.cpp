@@ -0,0 +1,119 @@
+#include "perf_counters.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+struct EventSpec {
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+constexpr std::uint64_t cache_miss(std::uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// Indexed by PerfCounters::Event.
+constexpr EventSpec kSpecs[PerfCounters::kEvents] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D) },
+    { PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_DTLB) },
+};
+
+int open_event(const EventSpec& spec, int group) {
+    perf_event_attr attr{};
+    attr.size           = sizeof attr;
+    attr.type           = spec.type;
+    attr.config         = spec.config;
+    attr.disabled       = group < 0;  // members follow the leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+#endif
+
+}  // namespace
+
+PerfCounters::PerfCounters() {
+    fds_.fill(-1);
+#ifdef __linux__
+    for (std::size_t e = 0; e < kEvents; ++e) {
+        const int fd = open_event(kSpecs[e], leader_);
+        if (fd < 0) {
+            if (error_.empty()) error_ = std::string(name(static_cast<Event>(e))) + ": " + std::strerror(errno);
+            continue;
+        }
+        if (leader_ < 0) leader_ = fd;
+        fds_[e] = fd;
+        order_[opened_++] = static_cast<Event>(e);
+    }
+    reset();
+#else
+    error_ = "perf_event_open is Linux-only";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds_) if (fd >= 0) ::close(fd);
+#endif
+}
+
+void PerfCounters::start() noexcept {
+#ifdef __linux__
+    if (leader_ >= 0) ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void PerfCounters::stop() noexcept {
+#ifdef __linux__
+    if (leader_ >= 0) ::ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void PerfCounters::reset() noexcept {
+#ifdef __linux__
+    if (leader_ >= 0) ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+PerfCounters::Counts PerfCounters::read() const noexcept {
+    Counts counts{};
+#ifdef __linux__
+    if (leader_ < 0) return counts;
+    // { nr, time_enabled, time_running, value[nr] }
+    std::uint64_t buf[3 + kEvents] = {};
+    if (::read(leader_, buf, sizeof buf) < static_cast<ssize_t>((3 + opened_) * sizeof(std::uint64_t))) return counts;
+    const std::uint64_t enabled = buf[1], running = buf[2];
+    if (running == 0) return counts;  // the group never got the PMU
+    const double scale = static_cast<double>(enabled) / static_cast<double>(running);
+    for (std::size_t i = 0; i < opened_ && i < buf[0]; ++i)
+        counts[order_[i]] = static_cast<std::uint64_t>(static_cast<double>(buf[3 + i]) * scale);
+#endif
+    return counts;
+}
+
+const char* PerfCounters::name(Event e) noexcept {
+    switch (e) {
+    case Cycles:       return "cycles";
+    case Instructions: return "instructions";
+    case L1dMisses:    return "l1d_misses";
+    case LlcMisses:    return "llc_misses";
+    case BranchMisses: return "branch_misses";
+    case DtlbMisses:   return "dtlb_misses";
+    default:           return "?";
+    }
+}
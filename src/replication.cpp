@@ -0,0 +1,168 @@
+#include "replication.hpp"
+#include "risk.hpp"
+#include "snapshot.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+sockaddr_un unix_address(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof addr.sun_path) throw std::invalid_argument("socket path too long: " + path);
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+bool send_all(int fd, const void* data, std::size_t len) {
+    const auto* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p   += n;
+        len -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+constexpr std::size_t kReadChunk = 64 * 1024;
+
+}  // namespace
+
+// ── Primary ───────────────────────────────────────────────────────────────────
+
+ReplicationPrimary::ReplicationPrimary(const std::string& socket_path, std::uint64_t last_lsn)
+    : path_(socket_path), listen_fd_(-1), next_lsn_(last_lsn + 1) {
+    const sockaddr_un addr = unix_address(path_);
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) throw_errno("socket");
+    ::unlink(path_.c_str());
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0 ||
+        ::listen(listen_fd_, 4) != 0) {
+        ::close(listen_fd_);
+        throw_errno("listen " + path_);
+    }
+}
+
+ReplicationPrimary::~ReplicationPrimary() {
+    for (int fd : followers_) ::close(fd);
+    ::close(listen_fd_);
+    ::unlink(path_.c_str());
+}
+
+void ReplicationPrimary::append(const Command& cmd) {
+    JournalRecord rec{ next_lsn_++, cmd, 0 };
+    rec.checksum = journal_checksum(rec);
+    pending_.push_back(rec);
+}
+
+void ReplicationPrimary::send() {
+    const std::size_t bytes = pending_.size() * sizeof(JournalRecord);
+    for (std::size_t i = 0; i < followers_.size();) {
+        if (send_all(followers_[i], pending_.data(), bytes)) { ++i; continue; }
+        std::cerr << "Replication follower dropped: " << std::strerror(errno) << "\n";
+        ::close(followers_[i]);
+        followers_.erase(followers_.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+    pending_.clear();
+}
+
+void ReplicationPrimary::flush(const OrderBook& ob, const RiskEngine* risk) {
+    if (!pending_.empty()) send();
+
+    // The book now reflects exactly last_lsn(): a new follower starts there.
+    for (int fd; (fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC)) >= 0;) {
+        BookImage image = ob.capture();
+        image.lsn = last_lsn();
+        if (risk) risk->save(image);
+        std::ostringstream out;
+        write_snapshot(out, image);
+        const std::string bytes = out.str();
+        const std::uint64_t len = bytes.size();
+        if (!send_all(fd, &len, sizeof len) || !send_all(fd, bytes.data(), bytes.size())) {
+            ::close(fd);
+            continue;
+        }
+        followers_.push_back(fd);
+        std::cerr << "Replication follower joined at lsn " << image.lsn << "\n";
+    }
+}
+
+// ── Follower ──────────────────────────────────────────────────────────────────
+
+ReplicationFollower::ReplicationFollower(const std::string& socket_path) : fd_(-1) {
+    const sockaddr_un addr = unix_address(socket_path);
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) throw_errno("socket");
+    if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0) {
+        ::close(fd_);
+        throw_errno("connect " + socket_path);
+    }
+}
+
+ReplicationFollower::~ReplicationFollower() { ::close(fd_); }
+
+bool ReplicationFollower::poll(OrderBook& ob, int timeout_ms, RiskEngine* risk) {
+    pollfd p{ fd_, POLLIN, 0 };
+    const int r = ::poll(&p, 1, timeout_ms);
+    if (r < 0 && errno != EINTR) throw_errno("poll");
+    if (r <= 0) return true;
+
+    if (buf_.size() < used_ + kReadChunk) buf_.resize(used_ + kReadChunk);
+    const ssize_t n = ::read(fd_, buf_.data() + used_, kReadChunk);
+    if (n == 0) return false;
+    if (n < 0) {
+        if (errno == EINTR) return true;
+        if (errno == ECONNRESET) return false;
+        throw_errno("replication read");
+    }
+    used_ += static_cast<std::size_t>(n);
+    consume(ob, risk);
+    return true;
+}
+
+void ReplicationFollower::consume(OrderBook& ob, RiskEngine* risk) {
+    std::size_t off = 0;
+    if (!synced_) {
+        std::uint64_t len = 0;
+        if (used_ < sizeof len) return;
+        std::memcpy(&len, buf_.data(), sizeof len);
+        if (used_ - sizeof len < len) return;
+
+        std::istringstream in(std::string(buf_.data() + sizeof len, len));
+        BookImage image = read_snapshot(in);
+        ob.restore(image);
+        if (risk) risk->seed(image);
+        last_lsn_ = image.lsn;
+        synced_   = true;
+        off       = sizeof len + len;
+    }
+
+    JournalRecord rec;
+    for (; used_ - off >= sizeof rec; off += sizeof rec) {
+        std::memcpy(&rec, buf_.data() + off, sizeof rec);
+        if (rec.lsn != last_lsn_ + 1 || rec.checksum != journal_checksum(rec))
+            throw std::runtime_error("replication stream corrupt at lsn " + std::to_string(last_lsn_ + 1));
+        (void)apply_command(ob, rec.cmd);
+        last_lsn_ = rec.lsn;
+    }
+    std::memmove(buf_.data(), buf_.data() + off, used_ - off);
+    used_ -= off;
+}
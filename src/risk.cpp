@@ -0,0 +1,178 @@
+#include "risk.hpp"
+
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+std::string_view next_word(std::string_view& rest) {
+    std::size_t b = 0;
+    while (b < rest.size() && (rest[b] == ' ' || rest[b] == '\t' || rest[b] == '\r')) ++b;
+    std::size_t e = b;
+    while (e < rest.size() && rest[e] != ' ' && rest[e] != '\t' && rest[e] != '\r') ++e;
+    auto word = rest.substr(b, e - b);
+    rest.remove_prefix(e);
+    return word;
+}
+
+template <typename T>
+T parse_limit(std::string_view key, std::string_view value) {
+    T v{};
+    auto [p, ec] = std::from_chars(value.data(), value.data() + value.size(), v);
+    if (value.empty() || ec != std::errc{} || p != value.data() + value.size() || value[0] == '-')
+        throw std::invalid_argument("Invalid " + std::string(key) + ": '" + std::string(value) + "'");
+    return v;
+}
+
+}  // namespace
+
+const char* risk_reject_name(RiskReject r) {
+    switch (r) {
+    case RiskReject::None:       return "none";
+    case RiskReject::Qty:        return "max_qty";
+    case RiskReject::Notional:   return "max_notional";
+    case RiskReject::OpenOrders: return "max_open";
+    case RiskReject::PriceBand:  return "band";
+    case RiskReject::Position:   return "max_position";
+    case RiskReject::Account:    return "account";
+    }
+    return "unknown";
+}
+
+RiskLimits parse_risk_limits(std::string_view words, RiskLimits base) {
+    for (auto word = next_word(words); !word.empty(); word = next_word(words)) {
+        const auto eq = word.find('=');
+        if (eq == std::string_view::npos) throw std::invalid_argument("Expected key=value: '" + std::string(word) + "'");
+        const auto key = word.substr(0, eq), value = word.substr(eq + 1);
+        if      (key == "max_qty")      base.max_qty      = parse_limit<std::int64_t>(key, value);
+        else if (key == "max_notional") base.max_notional = parse_limit<std::int64_t>(key, value);
+        else if (key == "max_open")     base.max_open     = parse_limit<std::uint32_t>(key, value);
+        else if (key == "band")         base.band         = parse_limit<std::int64_t>(key, value);
+        else if (key == "max_position") base.max_position = parse_limit<std::int64_t>(key, value);
+        else throw std::invalid_argument("Unknown risk limit: '" + std::string(key) + "'");
+    }
+    return base;
+}
+
+RiskEngine::RiskEngine(AccountId max_account)
+    : slots_(static_cast<std::size_t>(max_account) + 1),
+      rejects_(slots_.size(), 0),
+      custom_(slots_.size(), false) {}
+
+void RiskEngine::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open risk config " + path);
+    std::string line;
+    for (int n = 1; std::getline(in, line); ++n) {
+        std::string_view rest = line;
+        if (const auto hash = rest.find('#'); hash != std::string_view::npos) rest = rest.substr(0, hash);
+        const auto who = next_word(rest);
+        if (who.empty()) continue;
+        try {
+            if (who == "default") {
+                set_default_limits(parse_risk_limits(rest));
+            } else {
+                AccountId account{};
+                auto [p, ec] = std::from_chars(who.data(), who.data() + who.size(), account);
+                if (ec != std::errc{} || p != who.data() + who.size())
+                    throw std::invalid_argument("Invalid account: '" + std::string(who) + "'");
+                set_limits(account, parse_risk_limits(rest));
+            }
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument(path + ":" + std::to_string(n) + ": " + e.what());
+        }
+    }
+}
+
+RiskEngine::Slot RiskEngine::to_slot(const RiskLimits& l, const Slot& state) {
+    Slot s = state;
+    s.max_qty      = l.max_qty      ? l.max_qty      : kNoLimit;
+    s.max_notional = l.max_notional ? l.max_notional : kNoLimit;
+    s.band         = l.band         ? l.band         : kNoLimit;
+    s.max_position = l.max_position ? l.max_position : kNoLimit;
+    s.max_open     = l.max_open     ? l.max_open     : std::numeric_limits<std::uint32_t>::max();
+    return s;
+}
+
+void RiskEngine::set_default_limits(const RiskLimits& limits) {
+    for (std::size_t a = 0; a < slots_.size(); ++a)
+        if (!custom_[a]) slots_[a] = to_slot(limits, slots_[a]);
+}
+
+void RiskEngine::set_limits(AccountId account, const RiskLimits& limits) {
+    if (account >= slots_.size())
+        throw std::invalid_argument("account " + std::to_string(account) + " above max " + std::to_string(max_account()));
+    slots_[account]  = to_slot(limits, slots_[account]);
+    custom_[account] = true;
+}
+
+RiskLimits RiskEngine::limits(AccountId account) const {
+    if (account >= slots_.size()) return {};
+    const Slot& s = slots_[account];
+    auto limit = [](std::int64_t v) { return v == kNoLimit ? 0 : v; };
+    return RiskLimits{ limit(s.max_qty), limit(s.max_notional),
+                       s.max_open == std::numeric_limits<std::uint32_t>::max() ? 0 : s.max_open,
+                       limit(s.band), limit(s.max_position) };
+}
+
+AccountRisk RiskEngine::account(AccountId account) const {
+    if (account >= slots_.size()) return {};
+    const Slot& s = slots_[account];
+    return AccountRisk{ s.position, s.open_buy, s.open_sell, s.open_orders, rejects_[account] };
+}
+
+void RiskEngine::seed(const BookImage& image) {
+    for (auto& s : slots_) {
+        s.position    = 0;
+        s.open_buy    = 0;
+        s.open_sell   = 0;
+        s.open_orders = 0;
+    }
+    for (const Order& o : image.orders) {
+        if (o.owner >= slots_.size()) continue;
+        Slot& s = slots_[o.owner];
+        (o.side == Side::Buy ? s.open_buy : s.open_sell) += o.qty;
+        ++s.open_orders;
+    }
+    for (const AccountPosition& p : image.positions)
+        if (p.account < slots_.size()) slots_[p.account].position = p.qty;
+}
+
+void RiskEngine::save(BookImage& image) const {
+    image.positions.clear();
+    for (std::size_t a = 0; a < slots_.size(); ++a)
+        if (slots_[a].position != 0)
+            image.positions.push_back(AccountPosition{ static_cast<AccountId>(a), slots_[a].position });
+}
+
+// Owners above max_account() can't have passed check(), but a book restored
+// from elsewhere may hold them: their events are passed on untracked.
+void RiskEngine::on_order(const OrderEvent& e) {
+    if (e.owner < slots_.size()) {
+        Slot& s = slots_[e.owner];
+        std::int64_t& open = e.side == Side::Buy ? s.open_buy : s.open_sell;
+        switch (e.type) {
+        case OrderEventType::Add:
+            open += e.qty;
+            ++s.open_orders;
+            break;
+        case OrderEventType::Execute:
+            open -= e.qty;
+            if (e.remaining == 0) --s.open_orders;
+            s.position += e.side == Side::Buy ? e.qty : -e.qty;
+            break;
+        case OrderEventType::Cancel:
+            open -= e.qty;
+            --s.open_orders;
+            break;
+        case OrderEventType::Reduce:
+            open -= e.qty;
+            break;
+        }
+    }
+    // The aggressor isn't resting (yet): only its position moves.
+    if (e.type == OrderEventType::Execute && e.contra_owner < slots_.size())
+        slots_[e.contra_owner].position += e.side == Side::Buy ? -e.qty : e.qty;
+    if (next_) next_->on_order(e);
+}
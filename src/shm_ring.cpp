@@ -0,0 +1,190 @@
+#include "shm_ring.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ── Layout (see shm_ring.hpp) ─────────────────────────────────────────────────
+
+namespace {
+
+constexpr std::size_t kOffMagic       = 0;
+constexpr std::size_t kOffVersion     = 8;
+constexpr std::size_t kOffCmdCap      = 12;
+constexpr std::size_t kOffEvtCap      = 16;
+constexpr std::size_t kOffCmdRecSize  = 20;
+constexpr std::size_t kOffEvtRecSize  = 24;
+constexpr std::size_t kOffEngineState = 28;
+constexpr std::size_t kOffClientState = 32;
+constexpr std::size_t kOffCmdHead     = 64;
+constexpr std::size_t kOffCmdTail     = 128;
+constexpr std::size_t kOffEvtHead     = 192;
+constexpr std::size_t kOffEvtTail     = 256;
+constexpr std::size_t kHeaderSize     = 512;
+
+constexpr std::size_t align64(std::size_t n) { return (n + 63) & ~std::size_t{63}; }
+
+std::size_t cmd_ring_offset() { return kHeaderSize; }
+std::size_t evt_ring_offset(std::uint32_t cmd_cap) {
+    return align64(kHeaderSize + std::size_t{cmd_cap} * sizeof(ShmCommand));
+}
+std::size_t total_size(std::uint32_t cmd_cap, std::uint32_t evt_cap) {
+    return evt_ring_offset(cmd_cap) + std::size_t{evt_cap} * sizeof(ShmEvent);
+}
+
+bool is_pow2(std::uint32_t v) { return v != 0 && (v & (v - 1)) == 0; }
+
+template <typename T>
+T& field(std::byte* base, std::size_t off) { return *reinterpret_cast<T*>(base + off); }
+
+template <typename T>
+std::atomic_ref<T> atomic_field(std::byte* base, std::size_t off) {
+    return std::atomic_ref<T>(field<T>(base, off));
+}
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+std::byte* map_fd(int fd, std::size_t size, const std::string& path) {
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) { ::close(fd); throw_errno("mmap " + path); }
+    ::close(fd);  // the mapping keeps the file alive
+    return static_cast<std::byte*>(p);
+}
+
+}  // namespace
+
+// ── Construction ──────────────────────────────────────────────────────────────
+
+ShmChannel::ShmChannel(std::byte* base, std::size_t size) : base_(base), size_(size) {}
+
+ShmChannel::ShmChannel(ShmChannel&& other) noexcept : base_(other.base_), size_(other.size_) {
+    other.base_ = nullptr;
+    other.size_ = 0;
+}
+
+ShmChannel::~ShmChannel() {
+    if (base_) ::munmap(base_, size_);
+}
+
+ShmChannel ShmChannel::create(const std::string& path,
+                              std::uint32_t cmd_capacity, std::uint32_t evt_capacity) {
+    if (!is_pow2(cmd_capacity) || !is_pow2(evt_capacity))
+        throw std::invalid_argument("ring capacities must be powers of two");
+
+    const std::size_t size = total_size(cmd_capacity, evt_capacity);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) throw_errno("open " + path);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) { ::close(fd); throw_errno("ftruncate " + path); }
+
+    std::byte* base = map_fd(fd, size, path);
+    std::memset(base, 0, kHeaderSize);
+    field<std::uint32_t>(base, kOffVersion)     = kVersion;
+    field<std::uint32_t>(base, kOffCmdCap)      = cmd_capacity;
+    field<std::uint32_t>(base, kOffEvtCap)      = evt_capacity;
+    field<std::uint32_t>(base, kOffCmdRecSize)  = sizeof(ShmCommand);
+    field<std::uint32_t>(base, kOffEvtRecSize)  = sizeof(ShmEvent);
+    field<std::uint32_t>(base, kOffClientState) = 1;
+    // Magic last: an attaching engine never sees a half-initialised header.
+    atomic_field<std::uint64_t>(base, kOffMagic).store(kMagic, std::memory_order_release);
+    return ShmChannel(base, size);
+}
+
+ShmChannel ShmChannel::attach(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0) throw_errno("open " + path);
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) { ::close(fd); throw_errno("fstat " + path); }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    if (size < kHeaderSize) { ::close(fd); throw std::runtime_error("shm file too small: " + path); }
+
+    ShmChannel ch(map_fd(fd, size, path), size);
+    std::byte* base = ch.base_;
+    if (atomic_field<std::uint64_t>(base, kOffMagic).load(std::memory_order_acquire) != kMagic)
+        throw std::runtime_error("bad shm magic: " + path);
+    if (field<std::uint32_t>(base, kOffVersion) != kVersion)
+        throw std::runtime_error("unsupported shm version: " + path);
+
+    const auto cmd_cap = field<std::uint32_t>(base, kOffCmdCap);
+    const auto evt_cap = field<std::uint32_t>(base, kOffEvtCap);
+    if (!is_pow2(cmd_cap) || !is_pow2(evt_cap) ||
+        field<std::uint32_t>(base, kOffCmdRecSize) != sizeof(ShmCommand) ||
+        field<std::uint32_t>(base, kOffEvtRecSize) != sizeof(ShmEvent) ||
+        total_size(cmd_cap, evt_cap) > size)
+        throw std::runtime_error("inconsistent shm header: " + path);
+    return ch;
+}
+
+// ── Rings ─────────────────────────────────────────────────────────────────────
+
+bool ShmChannel::pop_command(ShmCommand& out) {
+    const auto cap  = field<std::uint32_t>(base_, kOffCmdCap);
+    const auto head = atomic_field<std::uint64_t>(base_, kOffCmdHead).load(std::memory_order_relaxed);
+    const auto tail = atomic_field<std::uint64_t>(base_, kOffCmdTail).load(std::memory_order_acquire);
+    if (head == tail) return false;
+    std::memcpy(&out, base_ + cmd_ring_offset() + (head & (cap - 1)) * sizeof(ShmCommand),
+                sizeof(ShmCommand));
+    atomic_field<std::uint64_t>(base_, kOffCmdHead).store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool ShmChannel::push_event(const ShmEvent& ev) {
+    const auto cmd_cap = field<std::uint32_t>(base_, kOffCmdCap);
+    const auto cap     = field<std::uint32_t>(base_, kOffEvtCap);
+    const auto tail = atomic_field<std::uint64_t>(base_, kOffEvtTail).load(std::memory_order_relaxed);
+    const auto head = atomic_field<std::uint64_t>(base_, kOffEvtHead).load(std::memory_order_acquire);
+    if (tail - head >= cap) return false;
+    std::memcpy(base_ + evt_ring_offset(cmd_cap) + (tail & (cap - 1)) * sizeof(ShmEvent),
+                &ev, sizeof(ShmEvent));
+    atomic_field<std::uint64_t>(base_, kOffEvtTail).store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool ShmChannel::push_command(const ShmCommand& c) {
+    const auto cap  = field<std::uint32_t>(base_, kOffCmdCap);
+    const auto tail = atomic_field<std::uint64_t>(base_, kOffCmdTail).load(std::memory_order_relaxed);
+    const auto head = atomic_field<std::uint64_t>(base_, kOffCmdHead).load(std::memory_order_acquire);
+    if (tail - head >= cap) return false;
+    std::memcpy(base_ + cmd_ring_offset() + (tail & (cap - 1)) * sizeof(ShmCommand),
+                &c, sizeof(ShmCommand));
+    atomic_field<std::uint64_t>(base_, kOffCmdTail).store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool ShmChannel::pop_event(ShmEvent& out) {
+    const auto cmd_cap = field<std::uint32_t>(base_, kOffCmdCap);
+    const auto cap     = field<std::uint32_t>(base_, kOffEvtCap);
+    const auto head = atomic_field<std::uint64_t>(base_, kOffEvtHead).load(std::memory_order_relaxed);
+    const auto tail = atomic_field<std::uint64_t>(base_, kOffEvtTail).load(std::memory_order_acquire);
+    if (head == tail) return false;
+    std::memcpy(&out, base_ + evt_ring_offset(cmd_cap) + (head & (cap - 1)) * sizeof(ShmEvent),
+                sizeof(ShmEvent));
+    atomic_field<std::uint64_t>(base_, kOffEvtHead).store(head + 1, std::memory_order_release);
+    return true;
+}
+
+// ── State flags ───────────────────────────────────────────────────────────────
+
+void ShmChannel::set_engine_state(std::uint32_t s) {
+    atomic_field<std::uint32_t>(base_, kOffEngineState).store(s, std::memory_order_release);
+}
+
+void ShmChannel::set_client_state(std::uint32_t s) {
+    atomic_field<std::uint32_t>(base_, kOffClientState).store(s, std::memory_order_release);
+}
+
+std::uint32_t ShmChannel::engine_state() const {
+    return atomic_field<std::uint32_t>(base_, kOffEngineState).load(std::memory_order_acquire);
+}
+
+std::uint32_t ShmChannel::client_state() const {
+    return atomic_field<std::uint32_t>(base_, kOffClientState).load(std::memory_order_acquire);
+}
@@ -0,0 +1,40 @@
+#include "slow_log.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+SlowLog::SlowLog(std::uint64_t threshold_ns, std::size_t capacity)
+    : threshold_ns_(threshold_ns),
+      threshold_ticks_(static_cast<std::uint64_t>(static_cast<double>(threshold_ns) / CycleClock::ns_per_tick())),
+      capacity_(capacity) {
+    ring_.reserve(capacity_);
+}
+
+void SlowLog::record(const Command& cmd, std::uint64_t ticks, const std::vector<Trade>& trades, const OrderBook& ob) {
+    SlowOp op{};
+    op.seq     = total_++;
+    op.unix_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::system_clock::now().time_since_epoch()).count();
+    op.ns      = CycleClock::to_ns(ticks);
+    op.cmd     = cmd;
+    op.fills   = static_cast<std::uint32_t>(trades.size());
+    op.levels  = levels_touched(trades);
+    op.top = ob.depth(kSlowLogDepth);
+
+    if (ring_.size() < capacity_) {
+        ring_.push_back(std::move(op));
+    } else {
+        ring_[next_] = std::move(op);
+        next_ = (next_ + 1) % capacity_;
+    }
+}
+
+std::vector<SlowOp> SlowLog::entries(std::size_t max) const {
+    // Oldest entry is at next_ once the ring is full, at 0 before.
+    std::vector<SlowOp> out;
+    const std::size_t n = std::min(max, ring_.size());
+    out.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        out.push_back(ring_[(next_ + ring_.size() - 1 - i) % ring_.size()]);
+    return out;
+}
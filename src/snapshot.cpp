@@ -0,0 +1,166 @@
+#include "snapshot.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// ── Encoding ──────────────────────────────────────────────────────────────────
+
+namespace {
+
+constexpr char          kMagic[8] = { 'L', 'O', 'B', 'S', 'N', 'A', 'P', '1' };
+constexpr std::uint32_t kVersion  = 5;
+
+struct Header {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t lsn;
+    std::uint64_t next_seq;
+    std::uint64_t trade_hash;
+    std::uint64_t trade_count;
+    std::uint64_t event_seq;
+    std::uint64_t count;
+};
+
+struct Record {
+    OrderId       id;
+    std::int64_t  price;
+    std::int64_t  qty;
+    std::uint64_t seq;
+    Side          side;
+    std::uint8_t  pad[3];
+    AccountId     owner;
+};
+
+struct PositionRecord {
+    AccountId     account;
+    std::uint8_t  pad[4];
+    std::int64_t  qty;
+};
+
+static_assert(sizeof(Header) == 64 && sizeof(Record) == 40 && sizeof(PositionRecord) == 16, "snapshot layout");
+
+// Streams the bytes through FNV-1a so the trailer can be checked on load.
+struct Fnv {
+    std::uint64_t h = 14695981039346656037ULL;
+    void add(const void* data, std::size_t len) {
+        const auto* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < len; ++i) { h ^= p[i]; h *= 1099511628211ULL; }
+    }
+};
+
+void put(std::ostream& out, Fnv& fnv, const void* data, std::size_t len) {
+    fnv.add(data, len);
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(len));
+}
+
+void get(std::istream& in, Fnv& fnv, void* data, std::size_t len) {
+    if (!in.read(static_cast<char*>(data), static_cast<std::streamsize>(len)))
+        throw std::runtime_error("truncated snapshot");
+    fnv.add(data, len);
+}
+
+}  // namespace
+
+void write_snapshot(std::ostream& out, const BookImage& image) {
+    Fnv fnv;
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version     = kVersion;
+    h.record_size = sizeof(Record);
+    h.lsn         = image.lsn;
+    h.next_seq    = image.next_seq;
+    h.trade_hash  = image.trade_hash;
+    h.trade_count = image.trade_count;
+    h.event_seq   = image.event_seq;
+    h.count       = image.orders.size();
+    put(out, fnv, &h, sizeof h);
+
+    for (const Order& o : image.orders) {
+        Record r{};
+        r.id = o.id; r.price = o.price; r.qty = o.qty; r.seq = o.seq; r.side = o.side; r.owner = o.owner;
+        put(out, fnv, &r, sizeof r);
+    }
+    const std::uint64_t positions = image.positions.size();
+    put(out, fnv, &positions, sizeof positions);
+    for (const AccountPosition& p : image.positions) {
+        PositionRecord r{};
+        r.account = p.account; r.qty = p.qty;
+        put(out, fnv, &r, sizeof r);
+    }
+    out.write(reinterpret_cast<const char*>(&fnv.h), sizeof fnv.h);
+    if (!out) throw std::runtime_error("snapshot write failed");
+}
+
+BookImage read_snapshot(std::istream& in) {
+    Fnv fnv;
+    Header h{};
+    get(in, fnv, &h, sizeof h);
+    if (std::memcmp(h.magic, kMagic, sizeof kMagic) != 0 ||
+        h.version != kVersion || h.record_size != sizeof(Record))
+        throw std::runtime_error("not a snapshot (bad header)");
+
+    BookImage image;
+    image.lsn      = h.lsn;
+    image.next_seq    = h.next_seq;
+    image.trade_hash  = h.trade_hash;
+    image.trade_count = h.trade_count;
+    image.event_seq   = h.event_seq;
+    // h.count is unverified until the checksum: the vector grows with the
+    // records actually read, so a bad count fails as a truncated snapshot.
+    for (std::uint64_t i = 0; i < h.count; ++i) {
+        Record r;
+        get(in, fnv, &r, sizeof r);
+        image.orders.push_back(Order{ r.id, r.side, r.owner, r.price, r.qty, r.seq });
+    }
+    std::uint64_t positions = 0;
+    get(in, fnv, &positions, sizeof positions);
+    for (std::uint64_t i = 0; i < positions; ++i) {
+        PositionRecord r;
+        get(in, fnv, &r, sizeof r);
+        image.positions.push_back(AccountPosition{ r.account, r.qty });
+    }
+
+    std::uint64_t checksum = 0;
+    if (!in.read(reinterpret_cast<char*>(&checksum), sizeof checksum) || checksum != fnv.h)
+        throw std::runtime_error("corrupt snapshot (checksum mismatch)");
+    return image;
+}
+
+// ── Files ─────────────────────────────────────────────────────────────────────
+
+void write_file_durably(const std::string& path, const std::function<void(std::ostream&)>& fill) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::system_error(errno, std::generic_category(), "open " + tmp);
+        fill(out);
+        if (!out.flush()) throw std::runtime_error("write failed: " + tmp);
+    }
+    int fd = ::open(tmp.c_str(), O_RDONLY);
+    if (fd < 0 || ::fsync(fd) != 0) {
+        if (fd >= 0) ::close(fd);
+        throw std::system_error(errno, std::generic_category(), "fsync " + tmp);
+    }
+    ::close(fd);
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        throw std::system_error(errno, std::generic_category(), "rename " + tmp);
+}
+
+void write_snapshot_file(const std::string& path, const BookImage& image) {
+    write_file_durably(path, [&](std::ostream& out) { write_snapshot(out, image); });
+}
+
+std::optional<BookImage> load_snapshot_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::nullopt;
+    return read_snapshot(in);
+}
@@ -0,0 +1,133 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char          kMagic[8] = { 'L', 'O', 'B', 'T', 'R', 'C', '0', '1' };
+constexpr std::uint32_t kVersion  = 1;
+
+// Rings are created on a thread's first record and never freed, so a dump
+// (possibly from a signal handler) can walk them without locking.
+std::atomic<lob_trace::Ring*> g_rings[kTraceMaxThreads];
+std::atomic<std::uint32_t>    g_registered{0};
+
+std::atomic<double> g_ns_per_tick{0.0};  // set outside signal context
+char                g_signal_path[4096];
+
+bool write_all(int fd, const void* data, std::size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        const ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+}  // namespace
+
+lob_trace::Ring* lob_trace::register_thread() noexcept {
+    const std::uint32_t n = g_registered.fetch_add(1, std::memory_order_relaxed);
+    if (n >= kTraceMaxThreads) return nullptr;
+    Ring* ring = new (std::nothrow) Ring;
+    if (!ring) return nullptr;
+    ring->tid = n;
+    g_rings[n].store(ring, std::memory_order_release);
+    return ring;
+}
+
+long trace_dump(const char* path) noexcept {
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    const lob_trace::Ring* rings[kTraceMaxThreads];
+    std::uint32_t          count = 0;
+    const std::uint32_t    registered = std::min<std::uint32_t>(g_registered.load(std::memory_order_acquire),
+                                                                kTraceMaxThreads);
+    for (std::uint32_t i = 0; i < registered; ++i)
+        if (const auto* r = g_rings[i].load(std::memory_order_acquire)) rings[count++] = r;
+
+    TraceFileHeader fh{};
+    std::memcpy(fh.magic, kMagic, sizeof kMagic);
+    fh.version     = kVersion;
+    fh.record_size = sizeof(TraceRecord);
+    fh.ns_per_tick = g_ns_per_tick.load(std::memory_order_relaxed);
+    fh.rings       = count;
+    bool ok = write_all(fd, &fh, sizeof fh);
+
+    long total = 0;
+    for (std::uint32_t i = 0; ok && i < count; ++i) {
+        const lob_trace::Ring& r = *rings[i];
+        const std::uint64_t head = r.head.load(std::memory_order_acquire);
+        const std::uint64_t n    = std::min<std::uint64_t>(head, kTraceCapacity);
+        const TraceRingHeader rh{ r.tid, static_cast<std::uint32_t>(n), head - n };
+        ok = write_all(fd, &rh, sizeof rh);
+
+        // Oldest first: the tail of the slot array, then its start.
+        const std::size_t first = static_cast<std::size_t>((head - n) & (kTraceCapacity - 1));
+        const std::size_t run   = std::min<std::size_t>(static_cast<std::size_t>(n), kTraceCapacity - first);
+        ok = ok && write_all(fd, r.slots + first, run * sizeof(TraceRecord));
+        ok = ok && write_all(fd, r.slots, (static_cast<std::size_t>(n) - run) * sizeof(TraceRecord));
+        total += static_cast<long>(n);
+    }
+
+    const int saved = errno;
+    ::close(fd);
+    errno = saved;
+    return ok ? total : -1;
+}
+
+void trace_dump_on_signal(int signo, const std::string& path) {
+    if (path.size() >= sizeof g_signal_path) throw std::invalid_argument("trace path too long: " + path);
+    g_ns_per_tick.store(CycleClock::ns_per_tick(), std::memory_order_relaxed);
+    std::memcpy(g_signal_path, path.c_str(), path.size() + 1);
+
+    struct sigaction sa{};
+    sa.sa_handler = [](int) {
+        const int saved = errno;
+        (void)trace_dump(g_signal_path);
+        errno = saved;
+    };
+    sa.sa_flags = SA_RESTART;
+    ::sigaction(signo, &sa, nullptr);
+}
+
+TraceFile read_trace(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + path);
+
+    TraceFileHeader fh{};
+    if (!in.read(reinterpret_cast<char*>(&fh), sizeof fh) || std::memcmp(fh.magic, kMagic, sizeof kMagic) != 0)
+        throw std::runtime_error(path + ": not a trace dump");
+    if (fh.version != kVersion || fh.record_size != sizeof(TraceRecord))
+        throw std::runtime_error(path + ": unsupported trace version");
+
+    TraceFile tf;
+    tf.ns_per_tick = fh.ns_per_tick > 0 ? fh.ns_per_tick : CycleClock::ns_per_tick();
+    for (std::uint32_t i = 0; i < fh.rings; ++i) {
+        TraceRingHeader rh{};
+        if (!in.read(reinterpret_cast<char*>(&rh), sizeof rh)) throw std::runtime_error(path + ": truncated");
+        const std::size_t at = tf.records.size();
+        tf.records.resize(at + rh.records);
+        if (!in.read(reinterpret_cast<char*>(tf.records.data() + at), static_cast<std::streamsize>(rh.records * sizeof(TraceRecord))))
+            throw std::runtime_error(path + ": truncated");
+        tf.dropped += rh.dropped;
+    }
+    std::stable_sort(tf.records.begin(), tf.records.end(),
+                     [](const TraceRecord& a, const TraceRecord& b) { return a.tsc < b.tsc; });
+    return tf;
+}
@@ -0,0 +1,274 @@
+#include "workload.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <variant>
+
+// ── Presets ───────────────────────────────────────────────────────────────────
+// equity: a liquid stock quoted in cents, 100-share lots, high cancel ratio, most
+//   quotes within a few ticks of the touch, frequent small mid moves.
+// futures: large tick, deep queues concentrated at the touch (sticky mid),
+//   even higher cancel ratio, fat-tailed sizes, violent bursts.
+
+WorkloadConfig workload_preset(std::string_view name) {
+    WorkloadConfig c;
+    if (name == "uniform") {
+        // Approximately uniform: prices over mid-5 .. mid+5 whatever the side
+        // (the mid twice as likely as the rest), qty 1-10, cancels uniform
+        // over live orders. Shaped like the old fixed --bench mix but not the
+        // same stream, so its numbers don't compare with that mix's.
+        c.start_mid   = 100;
+        c.half_spread = 0;
+        c.max_depth   = 6;
+        c.cross_prob  = 0.5;
+        c.cross_depth = 6;
+        return c;
+    }
+    if (name == "equity") {
+        c.add_weight = 0.55; c.cancel_weight = 0.40; c.market_weight = 0.05;
+        c.start_mid = 10'000; c.tick = 1; c.half_spread = 1; c.mid_step_prob = 0.02;
+        c.depth_alpha = 1.6; c.max_depth = 100;
+        c.cross_prob = 0.03; c.cross_depth = 2;
+        c.lot = 100; c.size_min = 1; c.size_max = 50; c.market_size_min = 1; c.market_size_max = 20;
+        c.size_alpha = 1.3;
+        c.cancel_age_mean = 20;
+        c.gap_ns = 2000; c.burst_prob = 0.002; c.burst_len_mean = 200; c.burst_factor = 20;
+        return c;
+    }
+    if (name == "futures") {
+        c.add_weight = 0.48; c.cancel_weight = 0.47; c.market_weight = 0.05;
+        c.start_mid = 400'000; c.tick = 25; c.half_spread = 1; c.mid_step_prob = 0.002;
+        c.depth_alpha = 0.8; c.max_depth = 20;
+        c.cross_prob = 0.02; c.cross_depth = 1;
+        c.lot = 1; c.size_min = 1; c.size_max = 500; c.market_size_min = 1; c.market_size_max = 200;
+        c.size_alpha = 1.8;
+        c.cancel_age_mean = 50;
+        c.gap_ns = 1000; c.burst_prob = 0.001; c.burst_len_mean = 1000; c.burst_factor = 50;
+        return c;
+    }
+    throw std::invalid_argument("Unknown workload preset: " + std::string(name));
+}
+
+// ── Config files ──────────────────────────────────────────────────────────────
+
+namespace {
+
+using Field = std::variant<double WorkloadConfig::*, std::int64_t WorkloadConfig::*, std::uint64_t WorkloadConfig::*>;
+
+struct Key { std::string_view name; Field field; };
+
+const Key kKeys[] = {
+    { "seed",            &WorkloadConfig::seed },
+    { "add_weight",      &WorkloadConfig::add_weight },
+    { "cancel_weight",   &WorkloadConfig::cancel_weight },
+    { "market_weight",   &WorkloadConfig::market_weight },
+    { "start_mid",       &WorkloadConfig::start_mid },
+    { "tick",            &WorkloadConfig::tick },
+    { "half_spread",     &WorkloadConfig::half_spread },
+    { "mid_step_prob",   &WorkloadConfig::mid_step_prob },
+    { "depth_alpha",     &WorkloadConfig::depth_alpha },
+    { "max_depth",       &WorkloadConfig::max_depth },
+    { "cross_prob",      &WorkloadConfig::cross_prob },
+    { "cross_depth",     &WorkloadConfig::cross_depth },
+    { "lot",             &WorkloadConfig::lot },
+    { "size_min",        &WorkloadConfig::size_min },
+    { "size_max",        &WorkloadConfig::size_max },
+    { "market_size_min", &WorkloadConfig::market_size_min },
+    { "market_size_max", &WorkloadConfig::market_size_max },
+    { "size_alpha",      &WorkloadConfig::size_alpha },
+    { "cancel_age_mean", &WorkloadConfig::cancel_age_mean },
+    { "gap_ns",          &WorkloadConfig::gap_ns },
+    { "burst_prob",      &WorkloadConfig::burst_prob },
+    { "burst_len_mean",  &WorkloadConfig::burst_len_mean },
+    { "burst_factor",    &WorkloadConfig::burst_factor },
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+template <typename T>
+T parse_value(std::string_view v, std::string_view key) {
+    T out{};
+    auto [p, ec] = std::from_chars(v.data(), v.data() + v.size(), out);
+    if (v.empty() || ec != std::errc{} || p != v.data() + v.size())
+        throw std::invalid_argument("Invalid value for " + std::string(key) + ": '" + std::string(v) + "'");
+    return out;
+}
+
+void validate(const WorkloadConfig& c) {
+    auto require = [](bool ok, const char* what) {
+        if (!ok) throw std::invalid_argument(std::string("Invalid workload: ") + what);
+    };
+    require(c.add_weight >= 0 && c.cancel_weight >= 0 && c.market_weight >= 0 &&
+            c.add_weight + c.cancel_weight + c.market_weight > 0, "weights must be >= 0 and not all 0");
+    require(c.tick > 0 && c.lot > 0 && c.half_spread >= 0, "tick and lot must be > 0, half_spread >= 0");
+    require(c.max_depth > 0 && c.cross_depth > 0, "max_depth and cross_depth must be > 0");
+    require(c.size_min > 0 && c.size_max >= c.size_min, "need 0 < size_min <= size_max");
+    require(c.market_size_min > 0 && c.market_size_max >= c.market_size_min, "need 0 < market_size_min <= market_size_max");
+    require(c.gap_ns >= 0 && c.burst_factor >= 1, "gap_ns must be >= 0, burst_factor >= 1");
+    require(c.start_mid - (c.half_spread + c.max_depth) * c.tick > 0, "start_mid too low for max_depth");
+}
+
+}  // namespace
+
+WorkloadConfig load_workload_config(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open workload config " + path);
+    WorkloadConfig c;
+    std::string line;
+    std::size_t lineno = 0;
+    while (std::getline(in, line)) {
+        ++lineno;
+        std::string_view l = line;
+        if (auto hash = l.find('#'); hash != std::string_view::npos) l = l.substr(0, hash);
+        l = trim(l);
+        if (l.empty()) continue;
+        const auto eq = l.find('=');
+        if (eq == std::string_view::npos)
+            throw std::invalid_argument(path + ":" + std::to_string(lineno) + ": expected key = value");
+        const auto key = trim(l.substr(0, eq));
+        const auto val = trim(l.substr(eq + 1));
+        if (key == "preset") { c = workload_preset(val); continue; }
+
+        const Key* k = nullptr;
+        for (const auto& cand : kKeys) if (cand.name == key) k = &cand;
+        if (!k) throw std::invalid_argument(path + ":" + std::to_string(lineno) + ": unknown key " + std::string(key));
+        std::visit([&](auto member) {
+            using T = std::remove_reference_t<decltype(c.*member)>;
+            c.*member = parse_value<T>(val, key);
+        }, k->field);
+    }
+    validate(c);
+    return c;
+}
+
+WorkloadConfig resolve_workload(const std::string& preset_or_path) {
+    if (std::filesystem::exists(preset_or_path)) return load_workload_config(preset_or_path);
+    return workload_preset(preset_or_path);
+}
+
+// ── Generator ─────────────────────────────────────────────────────────────────
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig& cfg)
+    : cfg_(cfg), rng_(cfg.seed), mid_(cfg.start_mid) {
+    validate(cfg_);
+}
+
+// Integer in [lo, hi] with P(s) ~ s^-alpha, by inverting the continuous CDF
+// over [lo, hi + 1).
+std::int64_t WorkloadGenerator::draw_power(std::int64_t lo, std::int64_t hi, double alpha) {
+    const double u = coin_(rng_);
+    const double a = static_cast<double>(lo), b = static_cast<double>(hi + 1);
+    double x;
+    if (alpha == 0.0) {
+        x = a + u * (b - a);
+    } else if (std::abs(alpha - 1.0) < 1e-9) {
+        x = a * std::pow(b / a, u);
+    } else {
+        const double e  = 1.0 - alpha;
+        const double pa = std::pow(a, e), pb = std::pow(b, e);
+        x = std::pow(pa + u * (pb - pa), 1.0 / e);
+    }
+    return std::min(hi, std::max(lo, static_cast<std::int64_t>(x)));
+}
+
+bool WorkloadGenerator::pick_cancel(OrderId& id) {
+    const std::size_t live = live_.size() - dead_;
+    if (live == 0) return false;
+
+    std::size_t pos;
+    if (cfg_.cancel_age_mean > 0) {
+        std::exponential_distribution<double> age(1.0 / cfg_.cancel_age_mean);
+        const auto a = static_cast<std::size_t>(age(rng_));
+        pos = live_.size() - 1 - std::min(a, live_.size() - 1);
+        // The slot may be dead: take the nearest older live order, else newer.
+        std::size_t p = pos;
+        while (p > 0 && live_[p] == 0) --p;
+        if (live_[p] == 0) { p = pos; while (live_[p] == 0) ++p; }
+        pos = p;
+    } else {
+        // At most half the slots are dead, so this takes two tries on average.
+        std::uniform_int_distribution<std::size_t> any(0, live_.size() - 1);
+        do pos = any(rng_); while (live_[pos] == 0);
+    }
+    id = live_[pos];
+    live_[pos] = 0;
+    if (++dead_ * 2 > live_.size()) {
+        std::erase(live_, OrderId{0});
+        dead_ = 0;
+    }
+    return true;
+}
+
+std::uint64_t WorkloadGenerator::draw_gap() {
+    if (cfg_.gap_ns <= 0) return 0;
+    double mean = cfg_.gap_ns;
+    if (burst_left_ > 0) {
+        --burst_left_;
+        mean /= cfg_.burst_factor;
+    } else if (cfg_.burst_prob > 0 && coin_(rng_) < cfg_.burst_prob) {
+        std::geometric_distribution<std::uint64_t> len(1.0 / std::max(1.0, cfg_.burst_len_mean));
+        burst_left_ = len(rng_);
+        mean /= cfg_.burst_factor;
+    }
+    std::exponential_distribution<double> gap(1.0 / mean);
+    return static_cast<std::uint64_t>(gap(rng_));
+}
+
+WorkloadOp WorkloadGenerator::next() {
+    if (cfg_.mid_step_prob > 0 && coin_(rng_) < cfg_.mid_step_prob) {
+        const std::int64_t step = coin_(rng_) < 0.5 ? -cfg_.tick : cfg_.tick;
+        // Keep the deepest bid above zero.
+        if (mid_ + step - (cfg_.half_spread + cfg_.max_depth) * cfg_.tick > 0) mid_ += step;
+    }
+
+    WorkloadOp op{};
+    op.gap_ns = draw_gap();
+    Command& c = op.cmd;
+
+    const double total = cfg_.add_weight + cfg_.cancel_weight + cfg_.market_weight;
+    double r = coin_(rng_) * total;
+    if (r >= cfg_.add_weight && r < cfg_.add_weight + cfg_.cancel_weight) {
+        if (pick_cancel(c.id)) {
+            c.type = CommandType::Cancel;
+            return op;
+        }
+        r = 0;  // nothing to cancel yet: add instead
+    }
+
+    if (r < cfg_.add_weight) {
+        c.type = CommandType::Add;
+        c.id   = next_id_++;
+        c.side = draw_side();
+        const std::int64_t dir = c.side == Side::Buy ? -1 : 1;  // away from the mid
+        if (cfg_.cross_prob > 0 && coin_(rng_) < cfg_.cross_prob) {
+            const std::int64_t through = draw_power(1, cfg_.cross_depth, 0.0) - 1;
+            c.price = mid_ - dir * (cfg_.half_spread + through) * cfg_.tick;
+        } else {
+            const std::int64_t d = draw_power(1, cfg_.max_depth, cfg_.depth_alpha) - 1;
+            c.price = mid_ + dir * (cfg_.half_spread + d) * cfg_.tick;
+        }
+        c.qty = cfg_.lot * draw_power(cfg_.size_min, cfg_.size_max, cfg_.size_alpha);
+        live_.push_back(c.id);
+    } else {
+        c.type = CommandType::Market;
+        c.id   = next_id_++;
+        c.side = draw_side();
+        c.qty  = cfg_.lot * draw_power(cfg_.market_size_min, cfg_.market_size_max, cfg_.size_alpha);
+    }
+    return op;
+}
+
+std::vector<WorkloadOp> WorkloadGenerator::generate(std::size_t n) {
+    std::vector<WorkloadOp> ops;
+    ops.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) ops.push_back(next());
+    return ops;
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include "order_book.hpp"
+
+TEST(BookHash, StateDependsOnRestingOrdersNotHistory) {
+    OrderBook a, b;
+    EXPECT_EQ(a.hash().state, 0u);
+
+    // a: order 2 rests after a partial fill; b: order 2 is cancelled. Same
+    // resting set afterwards except for order 2's remaining qty.
+    (void)a.add_limit(1, Side::Sell, 101, 10);
+    (void)a.add_limit(2, Side::Buy,  100, 5);
+    (void)b.add_limit(1, Side::Sell, 101, 10);
+    (void)b.add_limit(2, Side::Buy,  100, 5);
+    EXPECT_EQ(a.hash().state, b.hash().state);
+
+    auto ta = a.add_market(3, Side::Buy, 4);
+    auto tb = b.add_market(3, Side::Buy, 4);
+    EXPECT_EQ(a.hash().trades, b.hash().trades);
+    EXPECT_EQ(a.hash().trade_count, 1u);
+    EXPECT_EQ(a.hash().state, b.hash().state);
+
+    ASSERT_TRUE(b.cancel(2));
+    EXPECT_NE(a.hash().state, b.hash().state);
+    ASSERT_TRUE(a.cancel(2));
+    EXPECT_EQ(a.hash().state, b.hash().state);
+
+    // Cancelling everything returns to the empty-book hash
+    ASSERT_TRUE(a.cancel(1));
+    EXPECT_EQ(a.hash().state, 0u);
+
+    // A different fill sequence changes the trade chain
+    (void)b.add_market(4, Side::Buy, 1);
+    EXPECT_NE(a.hash().trades, b.hash().trades);
+}
+
+TEST(BookHash, RestoreKeepsHashes) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Buy,  100, 5);
+    (void)ob.add_limit(2, Side::Sell, 105, 3);
+    (void)ob.add_limit(3, Side::Sell, 104, 2);
+    (void)ob.add_limit(4, Side::Buy,  104, 1);  // partially fills order 3
+
+    OrderBook copy;
+    copy.restore(ob.capture());
+    EXPECT_EQ(copy.hash().state, ob.hash().state);
+    EXPECT_EQ(copy.hash().trades, ob.hash().trades);  // the chain carries over
+    EXPECT_EQ(copy.hash().trade_count, 1u);
+}
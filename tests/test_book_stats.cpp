@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "order_book.hpp"
+
+TEST(BookStats, CountsActivityAndShape) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Sell, 101, 5);
+    (void)ob.add_limit(2, Side::Sell, 102, 5);
+    (void)ob.add_limit(3, Side::Buy,   99, 5);
+    EXPECT_EQ(ob.stats().peak_levels, 3u);
+
+    // Fills order 1 completely and order 2 partly: two trades, one filled order.
+    EXPECT_EQ(ob.add_market(4, Side::Buy, 7).size(), 2u);
+    ASSERT_TRUE(ob.cancel(3));
+    EXPECT_FALSE(ob.cancel(3));
+
+    const BookStats s = ob.stats();
+    EXPECT_EQ(s.added, 4u);
+    EXPECT_EQ(s.trades, 2u);
+    EXPECT_EQ(s.filled, 1u);
+    EXPECT_EQ(s.cancelled, 1u);
+    EXPECT_EQ(s.rejected, 0u);
+    EXPECT_EQ(s.levels, 1u);
+    EXPECT_EQ(s.resting, 1u);
+    EXPECT_EQ(s.peak_levels, 3u);
+}
+
+TEST(BookStats, CountsRejectedCommands) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Buy, 100, 5);
+    EXPECT_THROW((void)ob.add_limit(1, Side::Buy, 100, 5), std::invalid_argument);
+    EXPECT_THROW((void)ob.add_limit(2, Side::Buy, 100, 0), std::invalid_argument);
+    EXPECT_THROW((void)ob.add_limit(3, Side::Buy, 0, 5), std::invalid_argument);
+    EXPECT_THROW((void)ob.add_market(1, Side::Sell, 5), std::invalid_argument);
+
+    const BookStats s = ob.stats();
+    EXPECT_EQ(s.rejected, 4u);
+    EXPECT_EQ(s.added, 1u);
+    EXPECT_EQ(s.resting, 1u);
+
+    // restore() replaces the shape but keeps the activity counts.
+    OrderBook copy;
+    copy.restore(ob.capture());
+    EXPECT_EQ(copy.stats().resting, 1u);
+    EXPECT_EQ(copy.stats().levels, 1u);
+}
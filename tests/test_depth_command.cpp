@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "command.hpp"
+
+TEST(DepthCommand, ParsesLevelsAndLeavesBookAlone) {
+    auto c = parse_command("DEPTH 5");
+    ASSERT_TRUE(c.has_value());
+    EXPECT_EQ(c->type, CommandType::Depth);
+    EXPECT_EQ(c->qty, 5);
+
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Buy, 100, 5);
+    const BookHash before = ob.hash();
+    EXPECT_TRUE(apply_command(ob, *c).empty());
+    EXPECT_EQ(ob.hash().state, before.state);
+
+    EXPECT_THROW((void)parse_command("DEPTH 0"), std::invalid_argument);
+    EXPECT_THROW((void)parse_command("DEPTH"), std::invalid_argument);
+}
+
+TEST(DepthCommand, TopLevelsBestFirst) {
+    OrderBook ob;
+    for (int i = 0; i < 10; ++i) {
+        (void)ob.add_limit(1 + i, Side::Buy,  100 - i, 1 + i);
+        (void)ob.add_limit(101 + i, Side::Sell, 110 + i, 2);
+    }
+    (void)ob.add_limit(50, Side::Buy, 99, 4);  // second order at 99
+
+    const BookDepth d = ob.depth(3);
+    ASSERT_EQ(d.bids.size(), 3u);
+    ASSERT_EQ(d.asks.size(), 3u);
+    EXPECT_EQ(d.bids[0].price, 100);
+    EXPECT_EQ(d.bids[1].price, 99);
+    EXPECT_EQ(d.bids[1].qty, 6);
+    EXPECT_EQ(d.bids[1].count, 2u);
+    EXPECT_EQ(d.bids[2].price, 98);
+    EXPECT_EQ(d.asks[0].price, 110);
+    EXPECT_EQ(d.asks[2].price, 112);
+}
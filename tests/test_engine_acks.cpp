@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "journal.hpp"
+#include "replication.hpp"
+
+// Drives the interactive engine (LOB_EXE, the lob binary) through pipes and
+// checks what has been journaled or replicated each time replies arrive, and
+// what a restarted engine recovers.
+
+namespace {
+
+struct Engine {
+    pid_t pid    = -1;
+    int   in_fd  = -1;  // engine's stdin
+    int   out_fd = -1;  // engine's stdout
+
+    explicit Engine(const std::vector<std::string>& args) {
+        int in[2], out[2];
+        if (::pipe(in) != 0 || ::pipe(out) != 0) throw std::runtime_error("pipe");
+        pid = ::fork();
+        if (pid == 0) {
+            ::dup2(in[0], 0);
+            ::dup2(out[1], 1);
+            ::close(in[1]);
+            ::close(out[0]);
+            std::vector<char*> argv{ const_cast<char*>(LOB_EXE) };
+            for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+            argv.push_back(nullptr);
+            ::execv(LOB_EXE, argv.data());
+            ::_exit(127);
+        }
+        ::close(in[0]);
+        ::close(out[1]);
+        in_fd  = in[1];
+        out_fd = out[0];
+    }
+
+    ~Engine() {
+        if (in_fd >= 0) ::close(in_fd);
+        if (out_fd >= 0) ::close(out_fd);
+        int status = 0;
+        if (pid > 0) ::waitpid(pid, &status, 0);
+    }
+
+    // Reads until "READY".
+    void wait_ready() {
+        std::string got;
+        char c;
+        while (got.find("READY\n") == std::string::npos && ::read(out_fd, &c, 1) == 1) got += c;
+        ASSERT_NE(got.find("READY\n"), std::string::npos);
+    }
+
+    // Writes `input` from another thread and closes stdin; calls `on_chunk`
+    // with the number of OK replies seen so far after every read.
+    void pipeline(const std::string& input, const std::function<void(std::size_t)>& on_chunk) {
+        std::thread writer([&] {
+            for (std::size_t off = 0; off < input.size();) {
+                const ssize_t n = ::write(in_fd, input.data() + off, input.size() - off);
+                if (n <= 0) break;
+                off += static_cast<std::size_t>(n);
+            }
+            ::close(in_fd);
+            in_fd = -1;
+        });
+        std::string pending;
+        std::size_t oks = 0;
+        char buf[4096];
+        for (ssize_t n; (n = ::read(out_fd, buf, sizeof buf)) > 0;) {
+            pending.append(buf, static_cast<std::size_t>(n));
+            std::size_t nl;
+            while ((nl = pending.find('\n')) != std::string::npos) {
+                if (pending.compare(nl >= 2 ? nl - 2 : 0, 2, "OK") == 0) ++oks;
+                pending.erase(0, nl + 1);
+            }
+            on_chunk(oks);
+        }
+        writer.join();
+    }
+
+    // Writes a short `input`, closes stdin and returns everything the engine
+    // replied.
+    std::string run(const std::string& input) {
+        if (::write(in_fd, input.data(), input.size()) != static_cast<ssize_t>(input.size())) return {};
+        ::close(in_fd);
+        in_fd = -1;
+        std::string got;
+        char buf[4096];
+        for (ssize_t n; (n = ::read(out_fd, buf, sizeof buf)) > 0;) got.append(buf, static_cast<std::size_t>(n));
+        return got;
+    }
+};
+
+std::uint64_t journal_lsn(const std::string& path) {
+    JournalReader r(path);
+    JournalRecord rec;
+    while (r.next(rec)) {}
+    return r.last_lsn();
+}
+
+// More than 8 KB of pipelined ADDs, far beyond stdout's buffer in replies.
+std::string burst(std::size_t n) {
+    std::string s;
+    for (std::size_t i = 1; i <= n; ++i) {
+        const std::string id = std::to_string(i);
+        s.append("@").append(id).append(" ADD ").append(id).append(" BUY ")
+         .append(std::to_string(100 + i % 50)).append(" 1\n");
+    }
+    return s;
+}
+
+}  // namespace
+
+TEST(EngineAcks, NoAckBeforeJournalCommit) {
+    const std::string journal = ::testing::TempDir() + "engine_acks_" + std::to_string(::getpid()) + ".journal";
+    std::remove(journal.c_str());
+    const std::string input = burst(3000);
+    ASSERT_GT(input.size(), 8192u);
+    {
+        // Thresholds no burst reaches: only the batch end commits.
+        Engine e({ "--journal", journal, "--durability", "none", "--group-commit", "100000000",
+                   "--group-commit-us", "100000000" });
+        e.wait_ready();
+        std::size_t acked = 0;
+        e.pipeline(input, [&](std::size_t oks) {
+            acked = oks;
+            EXPECT_GE(journal_lsn(journal), oks);
+        });
+        EXPECT_EQ(acked, 3000u);
+    }
+    EXPECT_EQ(journal_lsn(journal), 3000u);
+    std::remove(journal.c_str());
+}
+
+TEST(EngineAcks, NoAckBeforeFollowersHaveTheBatch) {
+    const std::string sock = ::testing::TempDir() + "engine_acks_" + std::to_string(::getpid()) + ".sock";
+    const std::string input = burst(1000);  // replication stays within the socket buffer
+    ASSERT_GT(input.size(), 8192u);
+
+    Engine e({ "--replicate", sock });
+    e.wait_ready();
+    ReplicationFollower f(sock);
+    OrderBook ob;
+    std::size_t acked = 0;
+    e.pipeline(input, [&](std::size_t oks) {
+        acked = oks;
+        // Whatever was sent before these acks is already in the socket.
+        for (int idle = 0; f.last_lsn() < oks && idle < 100;) {
+            const std::uint64_t before = f.last_lsn();
+            ASSERT_TRUE(f.poll(ob, 0));
+            idle = f.last_lsn() == before ? idle + 1 : 0;
+        }
+        EXPECT_GE(f.last_lsn(), oks);
+    });
+    EXPECT_EQ(acked, 1000u);
+    EXPECT_EQ(ob.best_bid(), 149);
+}
+
+TEST(EngineRisk, PositionsSurviveARestart) {
+    const std::string base = ::testing::TempDir() + "engine_risk_" + std::to_string(::getpid());
+    const std::string journal = base + ".journal", snapshot = base + ".snap", limits = base + ".risk";
+    std::remove(journal.c_str());
+    std::remove(snapshot.c_str());
+    {
+        std::ofstream out(limits);
+        out << "default max_position=10\n";
+    }
+    const std::vector<std::string> args{ "--journal", journal, "--snapshot", snapshot, "--risk", limits };
+    {
+        // Account 1 buys 6 before the snapshot and 4 after it: long 10.
+        Engine e(args);
+        e.wait_ready();
+        const std::string got = e.run("ADD 1 SELL 100 10 OWNER 2\n"
+                                      "ADD 2 BUY 100 6 OWNER 1\n"
+                                      "SNAPSHOT\n"
+                                      "ADD 3 BUY 100 4 OWNER 1\n");
+        EXPECT_EQ(got.find("ERROR"), std::string::npos) << got;
+    }
+    Engine e(args);
+    e.wait_ready();
+    const std::string got = e.run("ADD 4 BUY 90 1 OWNER 1\nRISK 1\nRISK 2\n");
+    EXPECT_NE(got.find("ERROR risk: max_position"), std::string::npos) << got;
+    EXPECT_NE(got.find("RISK account=1 position=10 "), std::string::npos) << got;
+    EXPECT_NE(got.find("RISK account=2 position=-10 "), std::string::npos) << got;
+    for (const auto& path : { journal, snapshot, limits }) std::remove(path.c_str());
+}
@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include "journal.hpp"
+
+TEST(Journal, ReplayRebuildsBookAndDropsTornTail) {
+    const std::string path = "/tmp/lob_test_journal_" + std::to_string(::getpid());
+    ::unlink(path.c_str());
+
+    {
+        JournalWriter w(path, JournalOptions{ Durability::None, 2 });
+        EXPECT_EQ(w.append(Command{ 1, 101, 10, CommandType::Add,    Side::Sell, {} }), 1u);
+        EXPECT_EQ(w.append(Command{ 2, 99,  5,  CommandType::Add,    Side::Buy,  {} }), 2u);
+        EXPECT_EQ(w.append(Command{ 3, 0,   4,  CommandType::Market, Side::Buy,  {} }), 3u);
+        EXPECT_EQ(w.append(Command{ 2, 0,   0,  CommandType::Cancel, Side::Buy,  {} }), 4u);
+    }
+
+    // Simulate a crash mid-write: half a record at the end
+    { std::ofstream(path, std::ios::app | std::ios::binary) << std::string(20, 'x'); }
+
+    OrderBook ob;
+    EXPECT_EQ(replay_journal(path, ob), 4u);
+    EXPECT_FALSE(ob.best_bid().has_value());
+    ASSERT_TRUE(ob.best_ask().has_value());
+    EXPECT_EQ(*ob.best_ask(), 101);
+
+    // Reopening truncates the torn record and continues the lsn sequence
+    {
+        JournalWriter w(path, JournalOptions{ Durability::Sync });
+        EXPECT_EQ(w.last_lsn(), 4u);
+        EXPECT_EQ(w.append(Command{ 5, 100, 1, CommandType::Add, Side::Buy, {} }), 5u);
+    }
+    OrderBook again;
+    EXPECT_EQ(replay_journal(path, again), 5u);
+    EXPECT_EQ(*again.best_bid(), 100);
+
+    ::unlink(path.c_str());
+}
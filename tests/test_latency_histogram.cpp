@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "latency.hpp"
+
+TEST(LatencyHistogram, BucketsCoverRangeWithBoundedError) {
+    using H = LatencyHistogram;
+    for (std::uint64_t v : { 0ull, 1ull, 127ull, 128ull, 129ull, 1000ull, 123456789ull, ~0ull }) {
+        const std::size_t i = H::index(v);
+        ASSERT_LT(i, H::kBuckets);
+        EXPECT_LE(H::lower_bound(i), v);
+        EXPECT_GE(H::upper_bound(i), v);
+        EXPECT_LE(H::upper_bound(i) - H::lower_bound(i), v / 64);
+    }
+    EXPECT_EQ(H::index(~0ull), H::kBuckets - 1);
+}
+
+TEST(LatencyHistogram, PercentilesAndMerge) {
+    LatencyHistogram a, b;
+    for (std::uint64_t v = 1; v <= 1000; ++v) a.record(v);
+    b.record(1'000'000);
+    EXPECT_EQ(a.count(), 1000u);
+    EXPECT_EQ(a.min(), 1u);
+    EXPECT_EQ(a.percentile(10), 100u);
+    const std::uint64_t p99 = a.percentile(99);
+    EXPECT_GE(p99, 990u);
+    EXPECT_LE(p99, 990u + 990u / 64);
+    EXPECT_EQ(a.percentile(100), 1000u);
+
+    a.merge(b);
+    EXPECT_EQ(a.count(), 1001u);
+    EXPECT_EQ(a.max(), 1'000'000u);
+    EXPECT_EQ(a.percentile(100), 1'000'000u);
+    EXPECT_LE(a.percentile(99.9), 1000u + 1000u / 64);  // upper end of its bucket
+
+    std::ostringstream out;
+    a.write_percentiles(out);
+    EXPECT_NE(out.str().find("Percentile"), std::string::npos);
+    EXPECT_NE(out.str().find("1000000.000 1.000000000000"), std::string::npos);
+}
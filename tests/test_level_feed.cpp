@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "order_book.hpp"
+
+namespace {
+struct Collector : BookListener {
+    std::vector<LevelUpdate> got;
+    void on_level(const LevelUpdate& u) override { got.push_back(u); }
+};
+}  // namespace
+
+TEST(LevelFeed, ReportsEachTouchedLevelOnce) {
+    OrderBook ob;
+    Collector c;
+    ob.set_listener(&c);
+
+    (void)ob.add_limit(1, Side::Sell, 101, 5);
+    (void)ob.add_limit(2, Side::Sell, 101, 3);
+    (void)ob.add_limit(3, Side::Sell, 102, 4);
+    ASSERT_EQ(c.got.size(), 3u);
+    EXPECT_EQ(c.got[1].level.qty, 8);
+    EXPECT_EQ(c.got[1].level.count, 2u);
+
+    // A sweep reports 101 once although two orders filled there; the buy
+    // is fully filled at 102, so no bid level appears.
+    c.got.clear();
+    (void)ob.add_limit(4, Side::Buy, 102, 10);
+    ASSERT_EQ(c.got.size(), 2u);
+    EXPECT_EQ(c.got[0].side, Side::Sell);
+    EXPECT_EQ(c.got[0].level.price, 101);
+    EXPECT_EQ(c.got[0].level.qty, 0);      // level removed
+    EXPECT_EQ(c.got[0].level.count, 0u);
+    EXPECT_EQ(c.got[1].level.price, 102);
+    EXPECT_EQ(c.got[1].level.qty, 2);
+    EXPECT_EQ(c.got[1].level.count, 1u);
+
+    c.got.clear();
+    ASSERT_TRUE(ob.cancel(3));
+    ASSERT_EQ(c.got.size(), 1u);
+    EXPECT_EQ(c.got[0].level.qty, 0);
+
+    ob.set_listener(nullptr);
+}
+
+TEST(LevelFeed, DepthMatchesAggregates) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Buy,  100, 5);
+    (void)ob.add_limit(2, Side::Buy,  100, 7);
+    (void)ob.add_limit(3, Side::Buy,  99,  1);
+    (void)ob.add_limit(4, Side::Sell, 103, 2);
+    (void)ob.add_market(5, Side::Sell, 6);  // leaves 6 @ 100 from order 2
+    ASSERT_TRUE(ob.cancel(3));
+
+    const BookDepth d = ob.depth();
+    ASSERT_EQ(d.bids.size(), 1u);
+    EXPECT_EQ(d.bids[0].price, 100);
+    EXPECT_EQ(d.bids[0].qty, 6);
+    EXPECT_EQ(d.bids[0].count, 1u);
+    ASSERT_EQ(d.asks.size(), 1u);
+    EXPECT_EQ(d.asks[0].qty, 2);
+
+    EXPECT_EQ(ob.depth(0).bids.size(), 0u);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "mapped_book.hpp"
+
+TEST(MappedBook, QueriesDepthInPlace) {
+    const std::string path = "/tmp/lob_test_mapped_" + std::to_string(::getpid());
+
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Buy,  100, 5);
+    (void)ob.add_limit(2, Side::Buy,  100, 7);
+    (void)ob.add_limit(3, Side::Buy,  98,  1);
+    (void)ob.add_limit(4, Side::Sell, 103, 2);
+    (void)ob.add_limit(5, Side::Sell, 101, 4);
+    (void)ob.add_limit(6, Side::Sell, 101, 1);
+    (void)ob.add_limit(7, Side::Buy,  101, 1);  // trades with 5: non-zero trade hash
+    BookImage image = ob.capture();
+    image.lsn = 42;
+    write_mapped_snapshot_file(path, image);
+
+    {
+        const MappedBook book(path);
+        EXPECT_EQ(book.lsn(), 42u);
+        EXPECT_EQ(book.next_seq(), image.next_seq);
+        EXPECT_EQ(*book.best_bid(), 100);
+        EXPECT_EQ(*book.best_ask(), 101);
+
+        ASSERT_EQ(book.bids().size(), 2u);
+        EXPECT_EQ(book.bids()[0].total_qty, 12);
+        EXPECT_EQ(book.bids()[1].price, 98);
+        ASSERT_EQ(book.asks().size(), 2u);
+        EXPECT_EQ(book.asks()[1].price, 103);
+
+        // FIFO within a level
+        auto lvl = book.orders(book.bids()[0]);
+        ASSERT_EQ(lvl.size(), 2u);
+        EXPECT_EQ(lvl[0].id, 1u);
+        EXPECT_EQ(lvl[1].id, 2u);
+
+        ASSERT_NE(book.find(5), nullptr);
+        EXPECT_EQ(book.find(5)->price, 101);
+        EXPECT_EQ(book.find(8), nullptr);
+
+        // Round-trips into a live book, trade-hash chain and L3 sequence included
+        OrderBook restored;
+        restored.restore(book.image());
+        EXPECT_EQ(restored.hash().trades, ob.hash().trades);
+        EXPECT_EQ(restored.hash().trade_count, 1u);
+        EXPECT_EQ(restored.capture().event_seq, image.event_seq);
+        EXPECT_NE(image.event_seq, 0u);
+        auto trades = restored.add_market(9, Side::Sell, 6);
+        ASSERT_EQ(trades.size(), 2u);
+        EXPECT_EQ(trades[0].buy_id, 1u);
+    }
+
+    // A truncated file is rejected instead of read out of bounds
+    ::truncate(path.c_str(), 100);
+    EXPECT_THROW(MappedBook{ path }, std::runtime_error);
+
+    ::unlink(path.c_str());
+}
+
+TEST(MappedBook, RejectsCountsThatWrapTheSizeCheck) {
+    const std::string path = "/tmp/lob_test_mapped_wrap_" + std::to_string(::getpid());
+    write_mapped_snapshot_file(path, OrderBook{}.capture());  // header only
+
+    // 2^60 orders * 48 bytes wraps to 0: the size would still "match".
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        const std::uint64_t count = std::uint64_t{1} << 60;
+        f.seekp(56);
+        f.write(reinterpret_cast<const char*>(&count), sizeof count);
+    }
+    EXPECT_THROW(MappedBook{ path }, std::runtime_error);
+    ::unlink(path.c_str());
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "order_book.hpp"
+
+namespace {
+struct Collector : BookListener {
+    std::vector<OrderEvent> got;
+    void on_order(const OrderEvent& e) override { got.push_back(e); }
+};
+}  // namespace
+
+TEST(OrderEvents, SequencedAddExecuteCancel) {
+    OrderBook ob;
+    Collector c;
+    (void)ob.add_limit(1, Side::Sell, 101, 5);  // event 1, before subscribing
+    ob.set_listener(&c);
+
+    (void)ob.add_limit(2, Side::Sell, 101, 3);
+    (void)ob.add_limit(3, Side::Buy,  101, 6);   // fills 1 fully, 2 partially
+    ASSERT_TRUE(ob.cancel(2));
+    ob.set_listener(nullptr);
+
+    ASSERT_EQ(c.got.size(), 4u);
+    EXPECT_EQ(c.got[0].event_seq, 2u);
+    EXPECT_EQ(c.got[0].type, OrderEventType::Add);
+    EXPECT_EQ(c.got[0].id, 2u);
+
+    EXPECT_EQ(c.got[1].type, OrderEventType::Execute);
+    EXPECT_EQ(c.got[1].id, 1u);
+    EXPECT_EQ(c.got[1].qty, 5);
+    EXPECT_EQ(c.got[1].remaining, 0);
+    EXPECT_EQ(c.got[1].contra, 3u);
+
+    EXPECT_EQ(c.got[2].id, 2u);
+    EXPECT_EQ(c.got[2].qty, 1);
+    EXPECT_EQ(c.got[2].remaining, 2);
+
+    EXPECT_EQ(c.got[3].type, OrderEventType::Cancel);
+    EXPECT_EQ(c.got[3].qty, 2);
+    EXPECT_EQ(c.got[3].event_seq, 5u);
+}
+
+TEST(OrderEvents, SnapshotAnchorsGapRecovery) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Buy, 100, 5);
+    (void)ob.add_limit(2, Side::Buy, 99,  5);
+
+    // A consumer that missed events resyncs from capture() and continues
+    // with the events after its event_seq.
+    const BookImage img = ob.capture();
+    EXPECT_EQ(img.event_seq, 2u);
+
+    Collector c;
+    ob.set_listener(&c);
+    ASSERT_TRUE(ob.cancel(1));
+    ASSERT_EQ(c.got.size(), 1u);
+    EXPECT_EQ(c.got[0].event_seq, img.event_seq + 1);
+    ob.set_listener(nullptr);
+
+    // The sequence survives restore
+    OrderBook copy;
+    copy.restore(ob.capture());
+    EXPECT_EQ(copy.capture().event_seq, 3u);
+}
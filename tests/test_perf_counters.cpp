@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "perf_counters.hpp"
+
+namespace {
+
+// A loop the compiler can't drop: roughly 4 instructions per iteration.
+std::uint64_t spin(std::uint64_t n) {
+    volatile std::uint64_t acc = 0;
+    for (std::uint64_t i = 0; i < n; ++i) acc = acc + i;
+    return acc;
+}
+
+}  // namespace
+
+TEST(PerfCounters, UnavailableEventsReadZero) {
+    PerfCounters pc;
+    pc.start();
+    (void)spin(10'000);
+    pc.stop();
+    const auto counts = pc.read();
+    for (std::size_t e = 0; e < PerfCounters::kEvents; ++e) {
+        const auto ev = static_cast<PerfCounters::Event>(e);
+        if (!pc.available(ev)) {
+            EXPECT_EQ(counts[e], 0u) << PerfCounters::name(ev);
+        }
+    }
+    if (!pc.available()) {
+        EXPECT_FALSE(pc.error().empty());
+    }
+}
+
+TEST(PerfCounters, CountsOnlyWhileStarted) {
+    PerfCounters pc;
+    if (!pc.available(PerfCounters::Instructions)) GTEST_SKIP() << "no PMU access: " << pc.error();
+
+    pc.start();
+    (void)spin(1'000'000);
+    pc.stop();
+    const auto first = pc.read();
+    EXPECT_GT(first[PerfCounters::Instructions], 1'000'000u);
+
+    (void)spin(1'000'000);  // stopped: not counted
+    EXPECT_EQ(pc.read()[PerfCounters::Instructions], first[PerfCounters::Instructions]);
+
+    pc.start();
+    (void)spin(1'000'000);
+    pc.stop();
+    EXPECT_GT(pc.read()[PerfCounters::Instructions], first[PerfCounters::Instructions] + 1'000'000u);
+
+    pc.reset();
+    EXPECT_EQ(pc.read()[PerfCounters::Instructions], 0u);
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "journal.hpp"
+#include "replay.hpp"
+
+TEST(Replay, ParallelDigestsMatchAcrossFormats) {
+    namespace fs = std::filesystem;
+    const fs::path dir = "/tmp/lob_test_replay_" + std::to_string(::getpid());
+    fs::remove_all(dir);
+    fs::create_directory(dir);
+
+    const char* text = "# demo\nADD 1 SELL 101 10\nADD 2 BUY 102 7\nADD 3 BUY 100 5\n"
+                       "CANCEL 3\nMARKET 5 BUY 4\n";
+    std::ofstream(dir / "a.txt") << text;
+    std::ofstream(dir / "b.txt") << text << "ADD 6 BUY 100 1\n";
+    std::ofstream(dir / "c.txt") << "ADD 1 BUY 100 1\nADD x BUY 100 1\n";
+    {
+        // Same commands as a.txt, journaled
+        JournalWriter w((dir / "d.jrnl").string(), JournalOptions{ Durability::None });
+        w.append(Command{ 1, 101, 10, CommandType::Add,    Side::Sell, {} });
+        w.append(Command{ 2, 102, 7,  CommandType::Add,    Side::Buy,  {} });
+        w.append(Command{ 3, 100, 5,  CommandType::Add,    Side::Buy,  {} });
+        w.append(Command{ 3, 0,   0,  CommandType::Cancel, Side::Buy,  {} });
+        w.append(Command{ 5, 0,   4,  CommandType::Market, Side::Buy,  {} });
+    }
+
+    const auto res = replay_paths(dir.string(), 3);
+    ASSERT_EQ(res.size(), 4u);
+    const auto& a = res[0]; const auto& b = res[1]; const auto& c = res[2]; const auto& d = res[3];
+
+    EXPECT_TRUE(a.error.empty());
+    EXPECT_EQ(a.commands, 5u);
+    EXPECT_EQ(a.trades, 2u);
+    EXPECT_EQ(a.trade_digest, d.trade_digest);
+    EXPECT_EQ(a.book_digest, d.book_digest);
+
+    EXPECT_EQ(a.trade_digest, b.trade_digest);  // same trades, different final book
+    EXPECT_NE(a.book_digest, b.book_digest);
+
+    EXPECT_NE(c.error.find("line 2"), std::string::npos);
+    EXPECT_EQ(c.commands, 1u);
+
+    fs::remove_all(dir);
+}
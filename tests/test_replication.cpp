@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+#include "replication.hpp"
+#include "risk.hpp"
+
+TEST(Replication, FollowerSyncsFromSnapshotThenStream) {
+    const std::string path = "/tmp/lob_test_repl_" + std::to_string(::getpid()) + ".sock";
+
+    OrderBook primary_book;
+    ReplicationPrimary primary(path, 0);
+    auto run = [&](const Command& c) { (void)apply_command(primary_book, c); primary.append(c); };
+
+    // Commands before the follower joins reach it through the snapshot
+    run(Command{ 1, 100, 5, CommandType::Add, Side::Buy,  {} });
+    run(Command{ 2, 103, 4, CommandType::Add, Side::Sell, {} });
+    primary.flush(primary_book);
+
+    ReplicationFollower follower(path);
+    EXPECT_FALSE(follower.synced());
+    primary.flush(primary_book);  // accepts it and sends the snapshot
+    EXPECT_EQ(primary.followers(), 1u);
+
+    run(Command{ 3, 0,   2, CommandType::Market, Side::Sell, {} });
+    run(Command{ 4, 101, 1, CommandType::Add,    Side::Sell, {} });
+    run(Command{ 2, 0,   0, CommandType::Cancel, Side::Buy,  {} });
+    primary.flush(primary_book);
+
+    OrderBook standby;
+    while (follower.last_lsn() < primary.last_lsn()) ASSERT_TRUE(follower.poll(standby, 1000));
+    EXPECT_TRUE(follower.synced());
+    EXPECT_EQ(follower.last_lsn(), 5u);
+    EXPECT_EQ(standby.hash().state, primary_book.hash().state);
+    EXPECT_EQ(standby.hash().trades, primary_book.hash().trades);
+    EXPECT_EQ(*standby.best_bid(), 100);
+    EXPECT_EQ(*standby.best_ask(), 101);
+}
+
+TEST(Replication, FollowerSeesEndOfStream) {
+    const std::string path = "/tmp/lob_test_repl_eos_" + std::to_string(::getpid()) + ".sock";
+    OrderBook book, standby;
+    auto primary = std::make_unique<ReplicationPrimary>(path, 7);
+    ReplicationFollower follower(path);
+    primary->flush(book);
+    primary.reset();  // the primary goes away
+
+    bool open = true;
+    for (int i = 0; i < 10 && open; ++i) open = follower.poll(standby, 1000);
+    EXPECT_FALSE(open);
+    EXPECT_TRUE(follower.synced());
+    EXPECT_EQ(follower.last_lsn(), 7u);
+}
+
+TEST(Replication, FollowerRiskTracksPrimaryPositions) {
+    const std::string path = "/tmp/lob_test_repl_risk_" + std::to_string(::getpid()) + ".sock";
+    OrderBook  book, standby;
+    RiskEngine risk(10), standby_risk(10);
+    book.set_listener(&risk);
+    standby.set_listener(&standby_risk);
+    ReplicationPrimary primary(path, 0);
+    auto run = [&](const Command& c) { (void)apply_command(book, c); primary.append(c); };
+
+    // A fill before the follower joins reaches it as a position in the snapshot ...
+    run(Command{ 1, 100, 5, CommandType::Add, Side::Buy,  {}, 0, 1 });
+    run(Command{ 2, 100, 3, CommandType::Add, Side::Sell, {}, 0, 2 });
+    ReplicationFollower follower(path);
+    primary.flush(book, &risk);
+
+    // ... and one after it through the stream.
+    run(Command{ 3, 0, 2, CommandType::Market, Side::Sell, {}, 0, 3 });
+    primary.flush(book, &risk);
+
+    while (follower.last_lsn() < primary.last_lsn()) ASSERT_TRUE(follower.poll(standby, 1000, &standby_risk));
+    for (AccountId a = 1; a <= 3; ++a) {
+        EXPECT_EQ(standby_risk.account(a).position, risk.account(a).position) << "account " << a;
+        EXPECT_EQ(standby_risk.account(a).open_buy_qty, risk.account(a).open_buy_qty) << "account " << a;
+    }
+    EXPECT_EQ(standby_risk.account(1).position, 5);
+    book.set_listener(nullptr);
+    standby.set_listener(nullptr);
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "risk.hpp"
+#include "snapshot.hpp"
+
+namespace {
+
+constexpr std::optional<std::int64_t> kNone;
+
+// Book in front of a risk engine, orders only reaching it past check().
+struct Gate {
+    OrderBook  ob;
+    RiskEngine risk{ 100 };
+
+    Gate() { ob.set_listener(&risk); }
+    ~Gate() { ob.set_listener(nullptr); }
+
+    RiskReject add(OrderId id, Side side, std::int64_t price, std::int64_t qty, AccountId owner) {
+        const RiskReject r = risk.check(owner, side, price, qty, ob.best_bid(), ob.best_ask());
+        if (r == RiskReject::None) (void)ob.add_limit(id, side, price, qty, owner);
+        return r;
+    }
+};
+
+}  // namespace
+
+TEST(Risk, NoLimitsByDefault) {
+    RiskEngine risk(10);
+    EXPECT_EQ(risk.check(3, Side::Buy, 100, 1'000'000'000, kNone, kNone), RiskReject::None);
+    EXPECT_EQ(risk.check(11, Side::Buy, 100, 1, kNone, kNone), RiskReject::Account);
+    EXPECT_THROW(risk.set_limits(11, RiskLimits{}), std::invalid_argument);
+}
+
+TEST(Risk, OrderSizeAndNotional) {
+    RiskEngine risk(10);
+    risk.set_limits(1, parse_risk_limits("max_qty=100 max_notional=5000"));
+    EXPECT_EQ(risk.check(1, Side::Buy, 10, 101, kNone, kNone), RiskReject::Qty);
+    EXPECT_EQ(risk.check(1, Side::Buy, 50, 100, kNone, kNone), RiskReject::None);
+    EXPECT_EQ(risk.check(1, Side::Buy, 51, 100, kNone, kNone), RiskReject::Notional);
+    // Market orders are valued at the touch they take, unchecked without one.
+    EXPECT_EQ(risk.check(1, Side::Buy, 0, 100, 40, 51), RiskReject::Notional);
+    EXPECT_EQ(risk.check(1, Side::Sell, 0, 100, 40, 51), RiskReject::None);
+    EXPECT_EQ(risk.check(1, Side::Buy, 0, 100, kNone, kNone), RiskReject::None);
+    EXPECT_EQ(risk.account(1).rejects, 3u);
+    EXPECT_EQ(risk.account(2).rejects, 0u);
+}
+
+TEST(Risk, PriceBandAroundTouch) {
+    RiskEngine risk(10);
+    risk.set_default_limits(parse_risk_limits("band=5"));
+    EXPECT_EQ(risk.check(1, Side::Buy, 105, 1, 99, 100), RiskReject::None);
+    EXPECT_EQ(risk.check(1, Side::Buy, 106, 1, 99, 100), RiskReject::PriceBand);
+    EXPECT_EQ(risk.check(1, Side::Buy, 94, 1, 99, 100), RiskReject::PriceBand);
+    // No asks: banded against the best bid instead; empty book: unbanded.
+    EXPECT_EQ(risk.check(1, Side::Buy, 94, 1, 99, kNone), RiskReject::None);
+    EXPECT_EQ(risk.check(1, Side::Buy, 1, 1, kNone, kNone), RiskReject::None);
+    EXPECT_EQ(risk.check(1, Side::Buy, 0, 1, 99, 100), RiskReject::None);  // market
+}
+
+TEST(Risk, OpenOrdersFollowTheBook) {
+    Gate g;
+    g.risk.set_limits(7, parse_risk_limits("max_open=2"));
+    EXPECT_EQ(g.add(1, Side::Sell, 101, 5, 7), RiskReject::None);
+    EXPECT_EQ(g.add(2, Side::Sell, 102, 5, 7), RiskReject::None);
+    EXPECT_EQ(g.add(3, Side::Sell, 103, 5, 7), RiskReject::OpenOrders);
+    EXPECT_EQ(g.risk.account(7).open_sell_qty, 10);
+
+    EXPECT_TRUE(g.ob.cancel(2));
+    EXPECT_EQ(g.add(3, Side::Sell, 103, 5, 7), RiskReject::None);
+
+    // Order 1 fully filled by account 8: one slot frees up.
+    (void)g.ob.add_market(10, Side::Buy, 5, 8);
+    const AccountRisk a = g.risk.account(7);
+    EXPECT_EQ(a.open_orders, 1u);
+    EXPECT_EQ(a.open_sell_qty, 5);
+    EXPECT_EQ(a.position, -5);
+    EXPECT_EQ(g.risk.account(8).position, 5);
+    EXPECT_EQ(g.risk.account(8).open_orders, 0u);
+}
+
+TEST(Risk, PositionCountsOpenOrders) {
+    Gate g;
+    g.risk.set_default_limits(parse_risk_limits("max_position=10"));
+    EXPECT_EQ(g.add(1, Side::Buy, 100, 6, 1), RiskReject::None);
+    EXPECT_EQ(g.add(2, Side::Buy, 99, 5, 1), RiskReject::Position);  // 6 open + 5
+    EXPECT_EQ(g.add(2, Side::Buy, 99, 4, 1), RiskReject::None);
+
+    // Account 2 sells into both bids: account 1 is long 10, nothing open.
+    EXPECT_EQ(g.add(3, Side::Sell, 99, 10, 2), RiskReject::None);
+    EXPECT_EQ(g.risk.account(1).position, 10);
+    EXPECT_EQ(g.risk.account(2).position, -10);
+    EXPECT_EQ(g.add(4, Side::Buy, 90, 1, 1), RiskReject::Position);
+    EXPECT_EQ(g.add(4, Side::Sell, 110, 20, 1), RiskReject::None);  // long 10, sells to short 10
+    EXPECT_EQ(g.add(5, Side::Sell, 111, 1, 1), RiskReject::Position);
+}
+
+TEST(Risk, SelfTradeReductionsAndSeed) {
+    Gate g;
+    (void)g.add(1, Side::Sell, 101, 5, 7);
+    (void)g.ob.add_limit(2, Side::Buy, 101, 3, 7, StpMode::Decrement);
+    EXPECT_EQ(g.risk.account(7).open_sell_qty, 2);
+    EXPECT_EQ(g.risk.account(7).open_orders, 1u);
+    EXPECT_EQ(g.risk.account(7).position, 0);
+
+    RiskEngine fresh(100);
+    fresh.seed(g.ob.capture());
+    EXPECT_EQ(fresh.account(7).open_sell_qty, 2);
+    EXPECT_EQ(fresh.account(7).open_orders, 1u);
+}
+
+TEST(Risk, ForwardsEventsAndLoadsConfig) {
+    struct Count : BookListener {
+        int orders = 0, levels = 0;
+        void on_order(const OrderEvent&) override { ++orders; }
+        void on_level(const LevelUpdate&) override { ++levels; }
+    } feed;
+    Gate g;
+    g.risk.forward_to(&feed);
+    (void)g.add(1, Side::Sell, 101, 5, 7);
+    EXPECT_EQ(feed.orders, 1);
+    EXPECT_EQ(feed.levels, 1);
+
+    const std::string path = ::testing::TempDir() + "risk_test.cfg";
+    {
+        std::ofstream out(path);
+        out << "# limits\ndefault max_qty=10\n\n7 max_qty=20 band=3  # market maker\n";
+    }
+    RiskEngine risk(100);
+    risk.load(path);
+    EXPECT_EQ(risk.limits(1).max_qty, 10);
+    EXPECT_EQ(risk.limits(7).max_qty, 20);
+    EXPECT_EQ(risk.limits(7).band, 3);
+    EXPECT_EQ(risk.limits(7).max_position, 0);
+
+    {
+        std::ofstream out(path);
+        out << "default max_qty=ten\n";
+    }
+    EXPECT_THROW(risk.load(path), std::invalid_argument);
+    EXPECT_THROW(parse_risk_limits("max_gain=1"), std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+TEST(Risk, OverflowIsABreach) {
+    constexpr std::int64_t kMax = std::numeric_limits<std::int64_t>::max();
+    Gate g;
+    g.risk.set_default_limits(parse_risk_limits("max_position=10"));  // max_qty unlimited
+    (void)g.add(1, Side::Buy, 100, 5, 2);
+    (void)g.add(2, Side::Sell, 100, 5, 1);  // account 1 short 5, account 2 long 5
+
+    // open_sell + qty - position and position + open_buy + qty would wrap.
+    EXPECT_EQ(g.risk.check(1, Side::Sell, 100, kMax - 2, kNone, kNone), RiskReject::Position);
+    EXPECT_EQ(g.risk.check(2, Side::Buy, 100, kMax, kNone, kNone), RiskReject::Position);
+
+    // A band near the limit must not wrap into rejecting everything ...
+    RiskEngine risk(10);
+    risk.set_default_limits(RiskLimits{ 0, 0, 0, kMax - 1, 0 });
+    EXPECT_EQ(risk.check(1, Side::Buy, 200, 1, 99, 100), RiskReject::None);
+    // ... and a price far enough from the touch to wrap is out of it.
+    risk.set_default_limits(parse_risk_limits("band=5"));
+    EXPECT_EQ(risk.check(1, Side::Buy, std::numeric_limits<std::int64_t>::min() + 1, 1, 99, 100),
+              RiskReject::PriceBand);
+}
+
+TEST(Risk, PositionsSurviveASnapshotAndItsTail) {
+    Gate g;
+    g.risk.set_default_limits(parse_risk_limits("max_position=10"));
+    (void)g.add(1, Side::Sell, 100, 8, 2);
+    (void)g.add(2, Side::Buy, 100, 8, 1);  // account 1 long 8
+    (void)g.add(3, Side::Buy, 99, 2, 1);
+    EXPECT_EQ(g.add(4, Side::Buy, 98, 1, 1), RiskReject::Position);
+
+    BookImage image = g.ob.capture();
+    g.risk.save(image);
+    std::stringstream buf;
+    write_snapshot(buf, image);
+
+    // A restarted engine gets the positions back with the book, and the
+    // commands replayed after the snapshot move them as they did live.
+    Gate restarted;
+    restarted.risk.set_default_limits(parse_risk_limits("max_position=10"));
+    const BookImage loaded = read_snapshot(buf);
+    restarted.ob.restore(loaded);
+    restarted.risk.seed(loaded);
+    EXPECT_EQ(restarted.risk.account(1).position, 8);
+    EXPECT_EQ(restarted.risk.account(2).position, -8);
+    EXPECT_EQ(restarted.risk.account(1).open_buy_qty, 2);
+    EXPECT_EQ(restarted.add(4, Side::Buy, 98, 1, 1), RiskReject::Position);
+
+    (void)restarted.ob.add_limit(5, Side::Sell, 99, 2, 2);  // fills order 3
+    EXPECT_EQ(restarted.risk.account(1).position, 10);
+    EXPECT_EQ(restarted.risk.account(2).position, -10);
+    EXPECT_EQ(restarted.add(6, Side::Buy, 98, 1, 1), RiskReject::Position);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "command.hpp"
+#include "order_book.hpp"
+
+namespace {
+
+struct EventLog : BookListener {
+    std::vector<OrderEvent> events;
+    void on_order(const OrderEvent& e) override { events.push_back(e); }
+};
+
+// Asks at 101: order 1 (account 7), then order 2 (account 8); order 3 (account 8) at 102.
+void seed(OrderBook& ob) {
+    (void)ob.add_limit(1, Side::Sell, 101, 5, 7);
+    (void)ob.add_limit(2, Side::Sell, 101, 5, 8);
+    (void)ob.add_limit(3, Side::Sell, 102, 5, 8);
+}
+
+}  // namespace
+
+TEST(SelfTrade, AnonymousOrdersAlwaysMatch) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Sell, 101, 5);
+    EXPECT_EQ(ob.add_limit(2, Side::Buy, 101, 5).size(), 1u);
+
+    // An owner only blocks orders with the same owner.
+    (void)ob.add_limit(3, Side::Sell, 101, 5, 7);
+    EXPECT_EQ(ob.add_limit(4, Side::Buy, 101, 5).size(), 1u);
+    EXPECT_EQ(ob.stats().prevented, 0u);
+}
+
+TEST(SelfTrade, CancelNewestDropsIncoming) {
+    OrderBook ob;
+    seed(ob);
+    // Buy 8 from account 7: order 1 is its own, first in line.
+    EXPECT_TRUE(ob.add_limit(10, Side::Buy, 102, 8, 7, StpMode::CancelNewest).empty());
+    EXPECT_FALSE(ob.cancel(10));  // never rested
+    EXPECT_EQ(ob.depth().asks[0].qty, 10);
+    EXPECT_EQ(ob.stats().prevented, 1u);
+}
+
+TEST(SelfTrade, CancelOldestRemovesRestingAndKeepsMatching) {
+    OrderBook ob;
+    seed(ob);
+    EventLog log;
+    ob.set_listener(&log);
+
+    const auto trades = ob.add_limit(10, Side::Buy, 102, 8, 7, StpMode::CancelOldest);
+    ASSERT_EQ(trades.size(), 2u);
+    EXPECT_EQ(trades[0].sell_id, 2u);
+    EXPECT_EQ(trades[1].sell_id, 3u);
+    EXPECT_EQ(trades[1].qty, 3);
+    EXPECT_FALSE(ob.cancel(1));
+    ASSERT_FALSE(log.events.empty());
+    EXPECT_EQ(log.events[0].type, OrderEventType::Cancel);
+    EXPECT_EQ(log.events[0].id, 1u);
+    EXPECT_EQ(log.events[0].qty, 5);
+
+    const BookStats s = ob.stats();
+    EXPECT_EQ(s.prevented, 1u);
+    EXPECT_EQ(s.filled, 1u);  // order 2; order 1 was cancelled, not filled
+    ob.set_listener(nullptr);
+}
+
+TEST(SelfTrade, CancelBothRemovesBoth) {
+    OrderBook ob;
+    seed(ob);
+    EXPECT_TRUE(ob.add_market(10, Side::Buy, 8, 7, StpMode::CancelBoth).empty());
+    EXPECT_FALSE(ob.cancel(1));
+    EXPECT_EQ(ob.depth().asks[0].qty, 5);  // order 2 untouched
+    EXPECT_EQ(*ob.best_ask(), 101);
+}
+
+TEST(SelfTrade, DecrementReducesBothWithoutTrading) {
+    OrderBook ob;
+    seed(ob);
+    EventLog log;
+    ob.set_listener(&log);
+
+    // Incoming 3 < resting 5: incoming gone, order 1 keeps 2 and its place.
+    EXPECT_TRUE(ob.add_limit(10, Side::Buy, 101, 3, 7, StpMode::Decrement).empty());
+    ASSERT_EQ(log.events.size(), 1u);
+    EXPECT_EQ(log.events[0].type, OrderEventType::Reduce);
+    EXPECT_EQ(log.events[0].qty, 3);
+    EXPECT_EQ(log.events[0].remaining, 2);
+
+    // Incoming 6 > resting 2: order 1 gone, the remaining 4 trade with order 2.
+    const auto trades = ob.add_limit(11, Side::Buy, 101, 6, 7, StpMode::Decrement);
+    ASSERT_EQ(trades.size(), 1u);
+    EXPECT_EQ(trades[0].sell_id, 2u);
+    EXPECT_EQ(trades[0].qty, 4);
+    EXPECT_FALSE(ob.cancel(1));
+    EXPECT_EQ(ob.stats().prevented, 2u);
+    ob.set_listener(nullptr);
+}
+
+TEST(SelfTrade, OwnerSurvivesSnapshotAndChangesStateHash) {
+    OrderBook a, b;
+    (void)a.add_limit(1, Side::Sell, 101, 5, 7);
+    (void)b.add_limit(1, Side::Sell, 101, 5);
+    EXPECT_NE(a.hash().state, b.hash().state);
+
+    std::stringstream buf;
+    a.snapshot(buf);
+    OrderBook copy;
+    copy.restore(buf);
+    EXPECT_EQ(copy.hash().state, a.hash().state);
+    EXPECT_TRUE(copy.add_limit(2, Side::Buy, 101, 5, 7).empty());
+}
+
+TEST(SelfTrade, ParsesOwnerAndMode) {
+    const auto c = parse_command("ADD 5 BUY 100 10 OWNER 42 STP DECREMENT");
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->owner, 42u);
+    EXPECT_EQ(c->stp, StpMode::Decrement);
+
+    const auto m = parse_command("MARKET 6 SELL 3 OWNER 9");
+    ASSERT_TRUE(m);
+    EXPECT_EQ(m->owner, 9u);
+    EXPECT_EQ(m->stp, StpMode::CancelNewest);
+
+    EXPECT_EQ(parse_command("ADD 5 BUY 100 10")->owner, 0u);
+    EXPECT_THROW(parse_command("ADD 5 BUY 100 10 STP SOMETIMES"), std::invalid_argument);
+    EXPECT_THROW(parse_command("ADD 5 BUY 100 10 OWNER"), std::invalid_argument);
+}
+
+TEST(SelfTrade, RejectsOutOfRangeBinaryCommands) {
+    OrderBook ob;
+    seed(ob);
+    // As decoded from the shm ring or the journal: no parser in between.
+    Command c{ 10, 101, 5, CommandType::Add, Side::Buy, {} };
+    c.owner = 7;
+    c.stp   = static_cast<StpMode>(9);
+    EXPECT_THROW(apply_command(ob, c), std::invalid_argument);
+    c.stp  = StpMode::CancelNewest;
+    c.side = static_cast<Side>(2);
+    EXPECT_THROW(apply_command(ob, c), std::invalid_argument);
+    EXPECT_EQ(ob.depth().asks[0].qty, 10);
+
+    // The book itself never spins on an unknown mode: it drops the incoming order.
+    EXPECT_TRUE(ob.add_limit(11, Side::Buy, 101, 5, 7, static_cast<StpMode>(9)).empty());
+    EXPECT_EQ(ob.stats().prevented, 1u);
+}
@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <string>
+#include "shm_ring.hpp"
+
+TEST(ShmRing, CommandsAndEventsRoundTripInOrder) {
+    const std::string path = "/tmp/lob_test_shm_" + std::to_string(::getpid());
+    auto client = ShmChannel::create(path, 4, 4);
+    auto engine = ShmChannel::attach(path);
+
+    ShmCommand c{};
+    c.cmd.type = CommandType::Add;
+    for (std::uint64_t tag = 1; tag <= 4; ++tag) {
+        c.tag = tag; c.cmd.id = tag * 10;
+        EXPECT_TRUE(client.push_command(c));
+    }
+    // Ring holds exactly `capacity` records
+    EXPECT_FALSE(client.push_command(c));
+
+    ShmCommand got{};
+    for (std::uint64_t tag = 1; tag <= 4; ++tag) {
+        ASSERT_TRUE(engine.pop_command(got));
+        EXPECT_EQ(got.tag, tag);
+        EXPECT_EQ(got.cmd.id, tag * 10);
+        EXPECT_EQ(got.cmd.type, CommandType::Add);
+    }
+    EXPECT_FALSE(engine.pop_command(got));
+
+    ShmEvent ev{};
+    ev.tag = 7; ev.type = ShmEventType::Ok;
+    EXPECT_TRUE(engine.push_event(ev));
+    ShmEvent out{};
+    ASSERT_TRUE(client.pop_event(out));
+    EXPECT_EQ(out.tag, 7u);
+    EXPECT_EQ(out.type, ShmEventType::Ok);
+    EXPECT_FALSE(client.pop_event(out));
+
+    ::unlink(path.c_str());
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "slow_log.hpp"
+
+namespace {
+
+const Command kAdd{ 9, 105, 12, CommandType::Add, Side::Buy, {} };
+
+}  // namespace
+
+TEST(SlowLog, KeepsOnlyOpsOverThreshold) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Sell, 101, 5);
+    (void)ob.add_limit(2, Side::Sell, 101, 5);
+    (void)ob.add_limit(3, Side::Sell, 102, 5);
+    (void)ob.add_limit(4, Side::Buy,   99, 5);
+    const auto trades = ob.add_limit(kAdd.id, kAdd.side, kAdd.price, kAdd.qty);
+    ASSERT_EQ(trades.size(), 3u);
+
+    SlowLog log(1'000'000);  // 1 ms
+    const std::uint64_t ms = static_cast<std::uint64_t>(1e6 / CycleClock::ns_per_tick());
+    EXPECT_FALSE(log.offer(kAdd, ms / 2, trades, ob));
+    EXPECT_TRUE(log.offer(kAdd, ms * 2, trades, ob));
+    EXPECT_EQ(log.total(), 1u);
+
+    const auto e = log.entries();
+    ASSERT_EQ(e.size(), 1u);
+    EXPECT_EQ(e[0].cmd.id, 9u);
+    EXPECT_EQ(e[0].levels, 2u);  // 101 twice, then 102
+    EXPECT_EQ(e[0].fills, 3u);
+    EXPECT_NEAR(static_cast<double>(e[0].ns), 2e6, 2e4);
+    ASSERT_EQ(e[0].top.bids.size(), 1u);
+    EXPECT_EQ(e[0].top.bids[0].price, 99);
+    ASSERT_EQ(e[0].top.asks.size(), 1u);  // what the sweep left of order 3
+    EXPECT_EQ(e[0].top.asks[0].price, 102);
+    EXPECT_EQ(e[0].top.asks[0].qty, 3);
+}
+
+TEST(SlowLog, BoundedNewestFirst) {
+    OrderBook ob;
+    SlowLog log(0, 3);
+    for (OrderId id = 1; id <= 5; ++id) {
+        Command c = kAdd;
+        c.id = id;
+        EXPECT_TRUE(log.offer(c, 1'000, {}, ob));
+    }
+    EXPECT_EQ(log.total(), 5u);
+    auto e = log.entries();
+    ASSERT_EQ(e.size(), 3u);
+    EXPECT_EQ(e[0].cmd.id, 5u);
+    EXPECT_EQ(e[2].cmd.id, 3u);
+    EXPECT_EQ(e[2].seq, 2u);
+    EXPECT_EQ(log.entries(1).size(), 1u);
+
+    log.clear();
+    EXPECT_TRUE(log.entries().empty());
+    EXPECT_TRUE(log.offer(kAdd, 1'000, {}, ob));
+    EXPECT_EQ(log.entries()[0].seq, 5u);
+
+    SlowLog off(0, 0);
+    EXPECT_FALSE(off.offer(kAdd, 1'000, {}, ob));
+}
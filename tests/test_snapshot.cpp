@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "journal.hpp"
+#include "snapshot.hpp"
+
+TEST(Snapshot, RestorePreservesPriorityAndSequence) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Buy,  100, 5);
+    (void)ob.add_limit(2, Side::Buy,  100, 7);
+    (void)ob.add_limit(3, Side::Buy,  99,  1);
+    (void)ob.add_limit(4, Side::Sell, 103, 2);
+
+    std::stringstream buf;
+    ob.snapshot(buf);
+
+    OrderBook copy;
+    (void)copy.add_limit(9, Side::Sell, 50, 1);  // replaced by restore()
+    copy.restore(buf);
+    EXPECT_EQ(*copy.best_bid(), 100);
+    EXPECT_EQ(*copy.best_ask(), 103);
+    EXPECT_FALSE(copy.cancel(9));
+
+    // The sequence counter continues where the original left off
+    EXPECT_EQ(copy.capture().next_seq, ob.capture().next_seq);
+    EXPECT_EQ(copy.hash().state, ob.hash().state);
+
+    // FIFO within the 100 level survives: id 1 fills before id 2
+    auto trades = copy.add_market(10, Side::Sell, 6);
+    ASSERT_EQ(trades.size(), 2u);
+    EXPECT_EQ(trades[0].buy_id, 1u);
+    EXPECT_EQ(trades[1].buy_id, 2u);
+}
+
+TEST(Snapshot, CorruptSnapshotIsRejected) {
+    OrderBook ob;
+    (void)ob.add_limit(1, Side::Sell, 101, 3);
+    std::stringstream buf;
+    ob.snapshot(buf);
+
+    std::string bytes = buf.str();
+    bytes[50] ^= 1;
+    std::istringstream corrupt(bytes);
+    EXPECT_THROW(OrderBook().restore(corrupt), std::runtime_error);
+
+    std::istringstream truncated(buf.str().substr(0, 60));
+    EXPECT_THROW(OrderBook().restore(truncated), std::runtime_error);
+
+    // An order count far beyond the file fails like any truncation, without
+    // sizing anything by it first.
+    bytes = buf.str();
+    const std::uint64_t huge = std::uint64_t{1} << 60;
+    std::memcpy(&bytes[56], &huge, sizeof huge);
+    std::istringstream oversized(bytes);
+    EXPECT_THROW(OrderBook().restore(oversized), std::runtime_error);
+}
+
+TEST(Snapshot, SnapshotPlusJournalTailRebuildsBook) {
+    const std::string jpath = "/tmp/lob_test_snapjrnl_" + std::to_string(::getpid());
+    const std::string spath = jpath + ".snap";
+    ::unlink(jpath.c_str());
+
+    OrderBook live;
+    {
+        JournalWriter w(jpath, JournalOptions{ Durability::None });
+        auto run = [&](const Command& c) { (void)apply_command(live, c); w.append(c); };
+        run(Command{ 1, 100, 5, CommandType::Add, Side::Buy,  {} });
+        run(Command{ 2, 102, 5, CommandType::Add, Side::Sell, {} });
+        w.commit();
+
+        BookImage image = live.capture();
+        image.lsn = w.last_lsn();
+        write_snapshot_file(spath, image);
+
+        run(Command{ 3, 101, 4, CommandType::Add,    Side::Buy, {} });
+        run(Command{ 1, 0,   0, CommandType::Cancel, Side::Buy, {} });
+    }
+
+    auto image = load_snapshot_file(spath);
+    ASSERT_TRUE(image.has_value());
+    EXPECT_EQ(image->lsn, 2u);
+
+    OrderBook recovered;
+    recovered.restore(*image);
+    EXPECT_EQ(replay_journal(jpath, recovered, image->lsn), 4u);
+    EXPECT_EQ(*recovered.best_bid(), 101);
+    EXPECT_EQ(*recovered.best_ask(), 102);
+    EXPECT_EQ(recovered.capture().orders.size(), live.capture().orders.size());
+    EXPECT_FALSE(load_snapshot_file(spath + ".missing").has_value());
+
+    ::unlink(jpath.c_str());
+    ::unlink(spath.c_str());
+}
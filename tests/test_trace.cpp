@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "order_book.hpp"
+#include "trace.hpp"
+
+namespace {
+
+// Each test traces from a fresh thread, so it owns a fresh ring whatever
+// else (a LOB_TRACE build's order book) traced before.
+template <class F>
+void on_new_thread(F f) {
+    std::thread t(f);
+    t.join();
+}
+
+std::vector<TraceRecord> records_of(const TraceFile& tf, std::uint32_t tid) {
+    std::vector<TraceRecord> out;
+    for (const auto& r : tf.records)
+        if (r.tid == tid) out.push_back(r);
+    return out;
+}
+
+}  // namespace
+
+TEST(Trace, DumpRoundTrip) {
+    const std::string path = ::testing::TempDir() + "trace_" + std::to_string(::getpid());
+    std::uint32_t tid = 0;
+    on_new_thread([&] {
+        lob_trace::emit(TraceOp::AddLimit, TracePhase::Begin, 7);
+        lob_trace::emit(TraceOp::Match, TracePhase::Begin, 7);
+        lob_trace::emit(TraceOp::Match, TracePhase::End, 7, 2, 3);
+        lob_trace::emit(TraceOp::AddLimit, TracePhase::End, 7, 2, 3);
+    });
+    ASSERT_GE(trace_dump(path.c_str()), 4);
+
+    const TraceFile tf = read_trace(path);
+    std::remove(path.c_str());
+    EXPECT_GT(tf.ns_per_tick, 0.0);
+    for (const auto& r : tf.records)
+        if (r.id == 7 && r.op == TraceOp::Match) tid = r.tid;
+    const auto recs = records_of(tf, tid);
+    ASSERT_EQ(recs.size(), 4u);
+    EXPECT_EQ(recs[0].op, TraceOp::AddLimit);
+    EXPECT_EQ(recs[0].phase, TracePhase::Begin);
+    EXPECT_EQ(recs[2].levels, 2u);
+    EXPECT_EQ(recs[2].fills, 3u);
+    EXPECT_EQ(recs[3].phase, TracePhase::End);
+    for (std::size_t i = 1; i < recs.size(); ++i) EXPECT_LE(recs[i - 1].tsc, recs[i].tsc);
+}
+
+TEST(Trace, RingKeepsNewestRecords) {
+    const std::string path = ::testing::TempDir() + "trace_wrap_" + std::to_string(::getpid());
+    constexpr std::uint64_t kExtra = 10;
+    on_new_thread([] {
+        for (std::uint64_t i = 0; i < kTraceCapacity + kExtra; ++i)
+            lob_trace::emit(TraceOp::Cancel, TracePhase::End, (1ull << 40) + i);
+    });
+    ASSERT_GE(trace_dump(path.c_str()), static_cast<long>(kTraceCapacity));
+
+    const TraceFile tf = read_trace(path);
+    std::remove(path.c_str());
+    EXPECT_GE(tf.dropped, kExtra);
+    std::uint32_t tid = 0;
+    for (const auto& r : tf.records)
+        if (r.id == (1ull << 40) + kExtra) tid = r.tid;
+    const auto recs = records_of(tf, tid);
+    ASSERT_EQ(recs.size(), kTraceCapacity);
+    EXPECT_EQ(recs.front().id, (1ull << 40) + kExtra);  // the first kExtra were overwritten
+    EXPECT_EQ(recs.back().id, (1ull << 40) + kTraceCapacity + kExtra - 1);
+}
+
+TEST(Trace, RejectsForeignFiles) {
+    const std::string path = ::testing::TempDir() + "trace_bad_" + std::to_string(::getpid());
+    FILE* f = std::fopen(path.c_str(), "w");
+    ASSERT_NE(f, nullptr);
+    std::fputs("not a trace dump, but long enough to hold a header", f);
+    std::fclose(f);
+    EXPECT_THROW(read_trace(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(Trace, RejectedCallsEndTheirSpan) {
+    if (!trace_enabled()) GTEST_SKIP() << "built without LOB_TRACE";
+    const std::string path = ::testing::TempDir() + "trace_reject_" + std::to_string(::getpid());
+    constexpr OrderId kId = (1ull << 41) + 1;
+    on_new_thread([] {
+        OrderBook ob;
+        EXPECT_THROW((void)ob.add_limit(kId, Side::Buy, 100, 0), std::invalid_argument);
+        EXPECT_THROW((void)ob.add_market(kId, Side::Buy, 0), std::invalid_argument);
+    });
+    ASSERT_GE(trace_dump(path.c_str()), 4);
+    const TraceFile tf = read_trace(path);
+    std::remove(path.c_str());
+
+    std::vector<TraceRecord> recs;
+    for (const auto& r : tf.records)
+        if (r.id == kId) recs.push_back(r);
+    ASSERT_EQ(recs.size(), 4u);
+    for (std::size_t i = 0; i < recs.size(); i += 2) {
+        EXPECT_EQ(recs[i].phase, TracePhase::Begin);
+        EXPECT_EQ(recs[i + 1].phase, TracePhase::End);
+        EXPECT_EQ(recs[i + 1].op, recs[i].op);
+        EXPECT_EQ(recs[i + 1].flags, kTraceRejected);
+    }
+}
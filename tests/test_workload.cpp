@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include "workload.hpp"
+
+TEST(Workload, DeterministicAndWellFormed) {
+    const WorkloadConfig cfg = workload_preset("equity");
+    const auto a = WorkloadGenerator(cfg).generate(20000);
+    const auto b = WorkloadGenerator(cfg).generate(20000);
+    ASSERT_EQ(a.size(), b.size());
+
+    std::set<OrderId> added;
+    std::size_t cancels = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        const Command& c = a[i].cmd;
+        EXPECT_EQ(c.type, b[i].cmd.type);
+        EXPECT_EQ(c.id, b[i].cmd.id);
+        EXPECT_EQ(c.price, b[i].cmd.price);
+        EXPECT_EQ(a[i].gap_ns, b[i].gap_ns);
+        if (c.type == CommandType::Add) {
+            EXPECT_GT(c.price, 0);
+            EXPECT_EQ(c.qty % cfg.lot, 0);
+            added.insert(c.id);
+        } else if (c.type == CommandType::Cancel) {
+            ++cancels;
+            EXPECT_EQ(added.erase(c.id), 1u);  // cancels name live orders, once
+        }
+    }
+    EXPECT_GT(cancels, 0u);
+}
+
+TEST(Workload, ConfigFileOverridesPreset) {
+    const std::string path = ::testing::TempDir() + "lob_workload.conf";
+    {
+        std::ofstream out(path);
+        out << "# comment\npreset = futures\nseed = 7\ncancel_weight = 0   # no cancels\n";
+    }
+    const WorkloadConfig c = load_workload_config(path);
+    EXPECT_EQ(c.tick, 25);
+    EXPECT_EQ(c.seed, 7u);
+    EXPECT_EQ(c.cancel_weight, 0.0);
+    for (const auto& op : WorkloadGenerator(c).generate(1000)) EXPECT_NE(op.cmd.type, CommandType::Cancel);
+
+    { std::ofstream out(path); out << "bogus = 1\n"; }
+    EXPECT_THROW((void)load_workload_config(path), std::invalid_argument);
+    std::remove(path.c_str());
+    EXPECT_THROW((void)workload_preset("nope"), std::invalid_argument);
+}
@@ -0,0 +1,59 @@
+"""Ordering of the WebSocket fan-out (api/ws_manager.py) for a slow client."""
+import asyncio
+import json
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), ".."))
+
+from api.ws_manager import ConnectionManager  # noqa: E402
+
+
+class SlowSocket:
+    """Blocks in send_text until `gate` is set, recording every event sent."""
+
+    def __init__(self) -> None:
+        self.gate = asyncio.Event()
+        self.events: list[dict] = []
+
+    async def accept(self) -> None:
+        pass
+
+    async def send_text(self, text: str) -> None:
+        await self.gate.wait()
+        frame = json.loads(text)
+        self.events.extend(frame if isinstance(frame, list) else [frame])
+
+    async def close(self, code: int = 1000) -> None:
+        pass
+
+
+def book(version: int) -> dict:
+    return {"symbol": "AAPL", "version": version}
+
+
+class SlowClientOrdering(unittest.IsolatedAsyncioTestCase):
+    async def test_book_never_overtakes_an_earlier_trade(self) -> None:
+        mgr = ConnectionManager()
+        ws = SlowSocket()
+        await mgr.connect(ws)
+
+        await mgr.broadcast("book", book(0))
+        await asyncio.sleep(0)              # the writer is now stuck sending book 0
+        await mgr.broadcast("book", book(1))
+        await mgr.broadcast("trade", {"symbol": "AAPL", "qty": 5})
+        await mgr.broadcast("book", book(2))  # reflects the trade
+        await mgr.broadcast("book", book(3))  # conflated with book 2
+
+        ws.gate.set()
+        for _ in range(10):
+            await asyncio.sleep(0)
+
+        seen = [(e["event"], e["payload"].get("version")) for e in ws.events]
+        self.assertEqual(seen, [("book", 0), ("book", 1), ("trade", None), ("book", 3)])
+        await mgr.disconnect(ws)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,173 @@
+// lob_trace_decode — turns a trace dump (trace.hpp; written by TRACE or
+// SIGUSR2 in an engine built with -DLOB_TRACE=ON) into something readable.
+//
+// Begin and end records of one thread are paired into spans; Match spans
+// nest inside the AddLimit / AddMarket that ran them.
+//
+//   timeline  one line per book call, in time order (or the --top N slowest):
+//             "t_us=.. tid=.. op=.. id=.. dur_ns=.. match_ns=.. levels=.. fills=..
+//             [rejected=1]" (rejected: the call failed validation)
+//   folded    self time per stack in ns, for flamegraph.pl / speedscope
+//   chrome    Chrome trace-event JSON, for chrome://tracing / Perfetto
+//
+//   lob_trace_decode <dump> [--format timeline|folded|chrome] [--top N] [--min-us X]
+//
+// Operations whose begin has no end (still running when the dump was taken,
+// or traced by a build older than rejected end records) are counted on
+// stderr, not printed.
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "trace.hpp"
+
+namespace {
+
+struct Span {
+    TraceRecord   begin;
+    TraceRecord   end;
+    std::uint64_t child_ticks = 0;  // time in nested spans
+    int           depth       = 0;
+    std::string   stack;            // "lob;add_limit;match"
+};
+
+const char* op_name(TraceOp op) {
+    switch (op) {
+    case TraceOp::AddLimit:  return "add_limit";
+    case TraceOp::AddMarket: return "add_market";
+    case TraceOp::Cancel:    return "cancel";
+    case TraceOp::Match:     return "match";
+    }
+    return "unknown";
+}
+
+struct Decoded {
+    std::vector<Span> spans;          // in order of completion
+    std::uint64_t     unfinished = 0;  // begin without end
+    std::uint64_t     orphaned   = 0;  // end whose begin was overwritten
+    std::uint64_t     rejected   = 0;  // spans that failed validation
+};
+
+Decoded pair_spans(const std::vector<TraceRecord>& records) {
+    Decoded out;
+    std::map<std::uint32_t, std::vector<Span>> open;  // per thread, innermost last
+    for (const auto& r : records) {
+        auto& stack = open[r.tid];
+        if (r.phase == TracePhase::Begin) {
+            // Book calls don't nest (only Match runs inside one): whatever
+            // is still open was abandoned.
+            if (r.op != TraceOp::Match) {
+                out.unfinished += stack.size();
+                stack.clear();
+            }
+            Span s;
+            s.begin = r;
+            s.depth = static_cast<int>(stack.size());
+            s.stack = (stack.empty() ? std::string("lob") : stack.back().stack) + ";" + op_name(r.op);
+            stack.push_back(std::move(s));
+            continue;
+        }
+        // Begins left open above this end never finished (an exception).
+        auto it = std::find_if(stack.rbegin(), stack.rend(),
+                               [&](const Span& s) { return s.begin.op == r.op && s.begin.id == r.id; });
+        if (it == stack.rend()) { ++out.orphaned; continue; }
+        const auto keep = static_cast<std::size_t>(stack.rend() - it);
+        out.unfinished += stack.size() - keep;
+        stack.resize(keep);
+
+        Span s = std::move(stack.back());
+        stack.pop_back();
+        s.end = r;
+        if (r.flags & kTraceRejected) ++out.rejected;
+        if (!stack.empty()) stack.back().child_ticks += r.tsc - s.begin.tsc;
+        out.spans.push_back(std::move(s));
+    }
+    for (const auto& [tid, stack] : open) out.unfinished += stack.size();
+    return out;
+}
+
+int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " <dump> [--format timeline|folded|chrome] [--top N] [--min-us X]\n";
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argv[1][0] == '-') return usage(argv[0]);
+    std::string format = "timeline";
+    std::size_t top    = 0;
+    double      min_us = 0;
+    try {
+        for (int i = 2; i < argc; i += 2) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) return usage(argv[0]);
+            const std::string val = argv[i + 1];
+            if      (arg == "--format") format = val;
+            else if (arg == "--top")    top = std::stoull(val);
+            else if (arg == "--min-us") min_us = std::stod(val);
+            else return usage(argv[0]);
+        }
+        if (format != "timeline" && format != "folded" && format != "chrome")
+            throw std::invalid_argument("Unknown format: " + format);
+
+        const TraceFile tf = read_trace(argv[1]);
+        Decoded d = pair_spans(tf.records);
+        const double        npt    = tf.ns_per_tick;
+        const std::uint64_t origin = tf.records.empty() ? 0 : tf.records.front().tsc;
+        auto ns = [&](std::uint64_t ticks) { return static_cast<std::uint64_t>(static_cast<double>(ticks) * npt); };
+        auto dur = [&](const Span& s) { return ns(s.end.tsc - s.begin.tsc); };
+
+        std::cerr << "# records=" << tf.records.size() << " dropped=" << tf.dropped << " spans=" << d.spans.size()
+                  << " rejected=" << d.rejected << " unfinished=" << d.unfinished << " orphaned=" << d.orphaned
+                  << " ns_per_tick=" << npt << "\n";
+
+        // Outermost spans only: nested ones are reported inside their parent.
+        std::vector<const Span*> ops;
+        for (const auto& s : d.spans)
+            if (s.depth == 0 && static_cast<double>(dur(s)) >= min_us * 1000.0) ops.push_back(&s);
+        std::sort(ops.begin(), ops.end(), [](const Span* a, const Span* b) { return a->begin.tsc < b->begin.tsc; });
+        if (top > 0) {
+            std::stable_sort(ops.begin(), ops.end(), [&](const Span* a, const Span* b) { return dur(*a) > dur(*b); });
+            if (ops.size() > top) ops.resize(top);
+        }
+
+        if (format == "timeline") {
+            for (const Span* s : ops) {
+                std::cout << "t_us=" << static_cast<double>(ns(s->begin.tsc - origin)) / 1000.0
+                          << " tid=" << s->begin.tid << " op=" << op_name(s->begin.op) << " id=" << s->begin.id
+                          << " dur_ns=" << dur(*s) << " match_ns=" << ns(s->child_ticks)
+                          << " levels=" << s->end.levels << " fills=" << s->end.fills
+                          << (s->end.flags & kTraceRejected ? " rejected=1" : "") << "\n";
+            }
+        } else if (format == "folded") {
+            // Self time, so a parent's frame is not double-counted with its children's.
+            std::map<std::string, std::uint64_t> folded;
+            for (const auto& s : d.spans) {
+                if (static_cast<double>(dur(s)) < min_us * 1000.0) continue;
+                folded[s.stack] += ns(s.end.tsc - s.begin.tsc - s.child_ticks);
+            }
+            for (const auto& [stack, self_ns] : folded) std::cout << stack << " " << self_ns << "\n";
+        } else {
+            std::cout << "{\"traceEvents\":[";
+            const char* sep = "\n";
+            for (const auto& s : d.spans) {
+                if (static_cast<double>(dur(s)) < min_us * 1000.0) continue;
+                std::cout << sep << "{\"name\":\"" << op_name(s.begin.op) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                          << s.begin.tid << ",\"ts\":" << static_cast<double>(ns(s.begin.tsc - origin)) / 1000.0
+                          << ",\"dur\":" << static_cast<double>(dur(s)) / 1000.0 << ",\"args\":{\"id\":" << s.begin.id
+                          << ",\"levels\":" << s.end.levels << ",\"fills\":" << s.end.fills << "}}";
+                sep = ",\n";
+            }
+            std::cout << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}